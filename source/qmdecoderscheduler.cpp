@@ -0,0 +1,303 @@
+#include "qmdecoderscheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+struct ScheduledTask {
+    qint64 deadline { 0 };
+    qint64 submit_time { 0 };
+    quint64 seq { 0 };
+    int stream { -1 };
+    QmDecoderScheduler::Task fn;
+};
+
+// std::push_heap 为大顶堆，比较取反后堆顶为截止时间最早的任务，截止时间相同按提交顺序
+struct LaterDeadline {
+    bool operator()(const ScheduledTask& a, const ScheduledTask& b) const
+    {
+        return a.deadline != b.deadline ? a.deadline > b.deadline : a.seq > b.seq;
+    }
+};
+
+struct Worker {
+    std::mutex mutex;
+    std::vector<ScheduledTask> heap;
+};
+
+struct Stream {
+    QmDecoderScheduler::StreamStats stats;
+    qint64 wait_total_us { 0 };
+    int running { 0 };
+};
+
+// 当前线程所属的调度器与工作线程序号，用于把任务提交回本线程的堆
+thread_local const QmDecoderSchedulerPrivate* current_scheduler = nullptr;
+thread_local int current_worker = -1;
+} // namespace
+
+class QmDecoderSchedulerPrivate {
+public:
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::jthread> threads;
+
+    // 保护 streams 与休眠等待，加锁顺序在 Worker::mutex 之后
+    mutable std::mutex mutex;
+    std::condition_variable_any work_cv;
+    std::condition_variable idle_cv;
+    std::unordered_map<int, Stream> streams;
+    int next_stream { 0 };
+    int pending { 0 };
+    quint64 next_seq { 0 };
+    unsigned next_worker { 0 };
+
+    void workerLoop(int index, std::stop_token st);
+    bool take(int index, ScheduledTask* task);
+    void execute(ScheduledTask& task);
+    void removeTasks(int stream);
+    void waitIdle(std::unique_lock<std::mutex>& lock, int stream);
+};
+
+void QmDecoderSchedulerPrivate::workerLoop(int index, std::stop_token st)
+{
+    current_scheduler = this;
+    current_worker = index;
+    while (!st.stop_requested()) {
+        ScheduledTask task;
+        if (take(index, &task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock lock(mutex);
+        work_cv.wait(lock, st, [this] { return pending > 0; });
+    }
+}
+
+bool QmDecoderSchedulerPrivate::take(int index, ScheduledTask* task)
+{
+    // 选出所有堆顶中截止时间最早的一个，相同时优先本线程的堆，减少跨核迁移
+    const int count = static_cast<int>(workers.size());
+    int victim = -1;
+    qint64 earliest = 0;
+    for (int i = 0; i < count; ++i) {
+        const int candidate = (index + i) % count;
+        std::scoped_lock lock(workers[candidate]->mutex);
+        const std::vector<ScheduledTask>& heap = workers[candidate]->heap;
+        if (!heap.empty() && (victim < 0 || heap.front().deadline < earliest)) {
+            victim = candidate;
+            earliest = heap.front().deadline;
+        }
+    }
+    if (victim < 0) {
+        return false;
+    }
+    Worker* worker = workers[victim].get();
+    std::scoped_lock lock(worker->mutex);
+    // 扫描期间堆顶可能已被其他线程取走，取到什么执行什么，下一轮再重新比较
+    if (worker->heap.empty()) {
+        return false;
+    }
+    std::pop_heap(worker->heap.begin(), worker->heap.end(), LaterDeadline());
+    *task = std::move(worker->heap.back());
+    worker->heap.pop_back();
+    // 在释放 Worker::mutex 之前登记为运行中，cancel 移除任务后等待 running 归零即可覆盖已取出的任务
+    std::scoped_lock stream_lock(mutex);
+    --pending;
+    auto it = streams.find(task->stream);
+    if (it == streams.end()) {
+        return false;
+    }
+    ++it->second.running;
+    return true;
+}
+
+void QmDecoderSchedulerPrivate::execute(ScheduledTask& task)
+{
+    const qint64 start = QmDecoderScheduler::now();
+    task.fn();
+    const qint64 end = QmDecoderScheduler::now();
+
+    std::scoped_lock lock(mutex);
+    Stream& stream = streams[task.stream];
+    QmDecoderScheduler::StreamStats& stats = stream.stats;
+    ++stats.tasks;
+    stats.busy_us += end - start;
+    stream.wait_total_us += start - task.submit_time;
+    stats.mean_wait_us = stream.wait_total_us / stats.tasks;
+    if (start > task.deadline) {
+        ++stats.deadline_misses;
+        stats.max_lateness_us = std::max(stats.max_lateness_us, start - task.deadline);
+    }
+    --stream.running;
+    idle_cv.notify_all();
+}
+
+void QmDecoderSchedulerPrivate::removeTasks(int stream)
+{
+    int removed = 0;
+    for (const std::unique_ptr<Worker>& worker : workers) {
+        std::scoped_lock lock(worker->mutex);
+        removed += static_cast<int>(std::erase_if(worker->heap, [stream](const ScheduledTask& task) { return task.stream == stream; }));
+        std::make_heap(worker->heap.begin(), worker->heap.end(), LaterDeadline());
+    }
+    std::scoped_lock lock(mutex);
+    pending -= removed;
+}
+
+void QmDecoderSchedulerPrivate::waitIdle(std::unique_lock<std::mutex>& lock, int stream)
+{
+    idle_cv.wait(lock, [this, stream] {
+        auto it = streams.find(stream);
+        return it == streams.end() || it->second.running == 0;
+    });
+}
+
+QmDecoderScheduler::QmDecoderScheduler(int thread_count)
+    : d_(new QmDecoderSchedulerPrivate)
+{
+    const int cores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    thread_count = thread_count <= 0 ? cores : std::min(thread_count, cores);
+    for (int i = 0; i < thread_count; ++i) {
+        d_->workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        d_->threads.emplace_back([this, i](std::stop_token st) {
+            d_->workerLoop(i, st);
+        });
+    }
+}
+
+QmDecoderScheduler::~QmDecoderScheduler() noexcept
+{
+    for (std::jthread& thread : d_->threads) {
+        thread.request_stop();
+    }
+    d_->threads.clear();
+    delete d_;
+}
+
+QmDecoderScheduler* QmDecoderScheduler::instance()
+{
+    static QmDecoderScheduler scheduler;
+    return &scheduler;
+}
+
+qint64 QmDecoderScheduler::now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int QmDecoderScheduler::threadCount() const
+{
+    return static_cast<int>(d_->workers.size());
+}
+
+int QmDecoderScheduler::registerStream(const QString& name)
+{
+    std::scoped_lock lock(d_->mutex);
+    const int stream = d_->next_stream++;
+    Stream& state = d_->streams[stream];
+    state.stats.stream = stream;
+    state.stats.name = name;
+    return stream;
+}
+
+void QmDecoderScheduler::unregisterStream(int stream)
+{
+    d_->removeTasks(stream);
+    std::unique_lock lock(d_->mutex);
+    d_->waitIdle(lock, stream);
+    d_->streams.erase(stream);
+}
+
+void QmDecoderScheduler::post(int stream, qint64 deadline_us, Task task)
+{
+    ScheduledTask scheduled;
+    scheduled.deadline = deadline_us;
+    scheduled.submit_time = now();
+    scheduled.stream = stream;
+    scheduled.fn = std::move(task);
+    int index = 0;
+    {
+        std::scoped_lock lock(d_->mutex);
+        if (!d_->streams.contains(stream)) {
+            return;
+        }
+        scheduled.seq = d_->next_seq++;
+        // 工作线程中提交的后续任务放回本线程的堆，解码上下文留在同一核的缓存中；空闲线程仍可窃取
+        index = current_scheduler == d_ ? current_worker : static_cast<int>(d_->next_worker++ % d_->workers.size());
+    }
+    Worker* worker = d_->workers[index].get();
+    {
+        std::scoped_lock lock(worker->mutex);
+        worker->heap.push_back(std::move(scheduled));
+        std::push_heap(worker->heap.begin(), worker->heap.end(), LaterDeadline());
+    }
+    std::scoped_lock lock(d_->mutex);
+    ++d_->pending;
+    d_->work_cv.notify_one();
+}
+
+void QmDecoderScheduler::cancel(int stream)
+{
+    d_->removeTasks(stream);
+    std::unique_lock lock(d_->mutex);
+    d_->waitIdle(lock, stream);
+}
+
+QList<QmDecoderScheduler::StreamStats> QmDecoderScheduler::stats() const
+{
+    QList<StreamStats> result;
+    std::scoped_lock lock(d_->mutex);
+    for (const auto& [id, stream] : d_->streams) {
+        result.append(stream.stats);
+    }
+    std::sort(result.begin(), result.end(), [](const StreamStats& a, const StreamStats& b) { return a.stream < b.stream; });
+    return result;
+}
+
+QmDecoderScheduler::StreamStats QmDecoderScheduler::streamStats(int stream) const
+{
+    std::scoped_lock lock(d_->mutex);
+    auto it = d_->streams.find(stream);
+    return it == d_->streams.end() ? StreamStats() : it->second.stats;
+}
+
+double QmDecoderScheduler::fairness() const
+{
+    // Jain 指数：(Σx)² / (n·Σx²)，只统计执行过任务的流
+    double sum = 0;
+    double square_sum = 0;
+    int count = 0;
+    std::scoped_lock lock(d_->mutex);
+    for (const auto& [id, stream] : d_->streams) {
+        if (stream.stats.tasks == 0) {
+            continue;
+        }
+        const double wait = static_cast<double>(stream.stats.mean_wait_us);
+        sum += wait;
+        square_sum += wait * wait;
+        ++count;
+    }
+    if (count == 0 || square_sum <= 0) {
+        return 1.0;
+    }
+    return sum * sum / (count * square_sum);
+}
+
+void QmDecoderScheduler::resetStats()
+{
+    std::scoped_lock lock(d_->mutex);
+    for (auto& [id, stream] : d_->streams) {
+        const QString name = stream.stats.name;
+        stream.stats = StreamStats();
+        stream.stats.stream = id;
+        stream.stats.name = name;
+        stream.wait_total_us = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+
+#include "qmvideo_global.h"
+
+class QmDecoderSchedulerPrivate;
+
+// 多路解码共享的工作线程池，线程数不超过 CPU 核数
+// 每个工作线程维护一个按截止时间排序的任务堆，优先执行所有堆中截止时间最早的任务，自己的堆为空时从其他线程窃取；
+// 解码器以“预读队列播放完的时刻”作为截止时间提交解码任务，快要断帧的流先解码
+class QMVIDEO_LIB_EXPORT QmDecoderScheduler {
+public:
+    struct StreamStats {
+        int stream { -1 };
+        QString name;
+        qint64 tasks { 0 };
+        // 任务执行的总时长（单位：us）
+        qint64 busy_us { 0 };
+        // 任务从提交到开始执行的平均等待（单位：us）
+        qint64 mean_wait_us { 0 };
+        // 开始执行时已过截止时间的任务数及最大超时（单位：us）
+        qint64 deadline_misses { 0 };
+        qint64 max_lateness_us { 0 };
+    };
+
+    using Task = std::function<void()>;
+
+    // thread_count <= 0 或超过 CPU 核数时使用 CPU 核数
+    explicit QmDecoderScheduler(int thread_count = 0);
+    ~QmDecoderScheduler() noexcept;
+    Q_DISABLE_COPY_MOVE(QmDecoderScheduler)
+
+    // 进程内共享的实例
+    static QmDecoderScheduler* instance();
+    // 截止时间的时基：单调时钟（单位：us）
+    static qint64 now();
+
+    int threadCount() const;
+
+    int registerStream(const QString& name = QString());
+    // 丢弃该路尚未执行的任务并等待正在执行的任务结束，不能在该路的任务中调用
+    void unregisterStream(int stream);
+    // 提交任务，deadline 为期望开始执行的最晚时刻（now() 时基）；未注册的流忽略
+    void post(int stream, qint64 deadline_us, Task task);
+    // 与 unregisterStream 相同，但保留该路的注册与统计
+    void cancel(int stream);
+
+    QList<StreamStats> stats() const;
+    StreamStats streamStats(int stream) const;
+    // 各路平均等待时间的 Jain 公平性指数，取值 (0, 1]，1 表示各路等待相同
+    double fairness() const;
+    void resetStats();
+
+private:
+    QmDecoderSchedulerPrivate* d_ { nullptr };
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "qmdeliverytracker.h"
+#include "qmframepool.h"
+#include "qmvideoframe.h"
+#include <QImage>
+#include <algorithm>
+
+namespace {
+// 在途令牌，析构时计数减一；计数器由令牌共享，clear 之后析构的令牌只影响旧计数器
+struct ReleaseToken {
+    explicit ReleaseToken(std::shared_ptr<std::atomic_int> counter)
+        : counter(std::move(counter))
+    {
+        ++*this->counter;
+    }
+    ~ReleaseToken() noexcept
+    {
+        --*counter;
+    }
+    Q_DISABLE_COPY_MOVE(ReleaseToken)
+
+    std::shared_ptr<std::atomic_int> counter;
+};
+
+struct TrackedImage {
+    QImage image;
+    std::shared_ptr<ReleaseToken> token;
+};
+
+// 只读引用原图像素，消费者写入时会自动深拷贝
+QImage trackImage(const QImage& image, std::shared_ptr<ReleaseToken> token)
+{
+    auto* holder = new TrackedImage { image, std::move(token) };
+    return QImage(image.constBits(), image.width(), image.height(), image.bytesPerLine(), image.format(),
+        [](void* info) { delete static_cast<TrackedImage*>(info); }, holder);
+}
+} // namespace
+
+void QmDeliveryTracker::setLimit(int limit)
+{
+    std::scoped_lock lock(mutex_);
+    // 消费者通常保留当前显示的一帧（如 QmYuvView），上限为 1 时会一直等待
+    limit_ = std::max(limit, 2);
+}
+
+int QmDeliveryTracker::limit() const
+{
+    std::scoped_lock lock(mutex_);
+    return limit_;
+}
+
+void QmDeliveryTracker::setBytePool(QmFramePool* pool)
+{
+    std::scoped_lock lock(mutex_);
+    byte_pool_ = pool;
+}
+
+QVariant QmDeliveryTracker::track(const QVariant& data)
+{
+    const QMetaType type = data.metaType();
+    std::scoped_lock lock(mutex_);
+    if (type == QMetaType::fromType<QmVideoFrame>()) {
+        const QmVideoFrame frame = data.value<QmVideoFrame>();
+        return frame.isNull() ? data : QVariant::fromValue(frame.withReleaseToken(std::make_shared<ReleaseToken>(tokens_)));
+    }
+    if (type == QMetaType::fromType<QImage>()) {
+        const QImage image = data.value<QImage>();
+        return image.isNull() ? data : QVariant(trackImage(image, std::make_shared<ReleaseToken>(tokens_)));
+    }
+    if (type == QMetaType::fromType<QByteArray>()) {
+        QByteArray array = data.toByteArray();
+        if (array.isEmpty()) {
+            return data;
+        }
+        // 缓冲池交出自己的副本后，本类持有的是消费者之外唯一的引用
+        if (byte_pool_) {
+            byte_pool_->takeByteArray(array);
+        }
+        byte_arrays_.push_back(array);
+        return QVariant(array);
+    }
+    return data;
+}
+
+int QmDeliveryTracker::inFlight()
+{
+    std::scoped_lock lock(mutex_);
+    std::erase_if(byte_arrays_, [this](QByteArray& array) {
+        if (!array.isDetached()) {
+            return false;
+        }
+        if (byte_pool_) {
+            byte_pool_->recycleByteArray(array);
+        }
+        return true;
+    });
+    return tokens_->load() + static_cast<int>(byte_arrays_.size());
+}
+
+bool QmDeliveryTracker::hasSlot()
+{
+    return inFlight() < limit();
+}
+
+void QmDeliveryTracker::clear()
+{
+    std::scoped_lock lock(mutex_);
+    tokens_ = std::make_shared<std::atomic_int>(0);
+    byte_arrays_.clear();
+}
\ No newline at end of file
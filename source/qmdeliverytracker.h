@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QByteArray>
+#include <QVariant>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class QmFramePool;
+
+// 跟踪已发出、尚未被消费者全部释放的帧
+// QImage 与 QmVideoFrame 发出时换成共享原像素、附带释放令牌的新句柄，最后一个引用析构时令牌使在途数减一；
+// QByteArray 没有可挂接的析构回调，改为从缓冲池取回由本类独占的副本，副本重新变为独占时视为释放并交还缓冲池
+class QmDeliveryTracker {
+public:
+    void setLimit(int limit);
+    int limit() const;
+    // Yuv420p 输出的 QByteArray 来自该缓冲池
+    void setBytePool(QmFramePool* pool);
+
+    // 返回应发出的数据；无效或不支持的类型原样返回且不计入在途
+    QVariant track(const QVariant& data);
+    // 清理已释放的帧，返回在途帧数
+    int inFlight();
+    bool hasSlot();
+    // 不再跟踪已发出的帧，之后才释放的令牌不影响新的计数
+    void clear();
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<std::atomic_int> tokens_ { std::make_shared<std::atomic_int>(0) };
+    std::vector<QByteArray> byte_arrays_;
+    QmFramePool* byte_pool_ { nullptr };
+    int limit_ { 2 };
+};
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "qmframecache.h"
+
+void QmFrameCache::setBudget(qint64 budget)
+{
+    std::scoped_lock lock(mutex_);
+    budget_ = std::max<qint64>(budget, 0);
+    evict(budget_);
+}
+
+qint64 QmFrameCache::budget() const
+{
+    std::scoped_lock lock(mutex_);
+    return budget_;
+}
+
+bool QmFrameCache::isEnabled() const
+{
+    std::scoped_lock lock(mutex_);
+    return budget_ > 0;
+}
+
+QmVideoFrame QmFrameCache::find(qint64 frame_no)
+{
+    std::scoped_lock lock(mutex_);
+    auto it = lookup_.find(frame_no);
+    if (it == lookup_.end()) {
+        ++misses_;
+        return {};
+    }
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->frame;
+}
+
+void QmFrameCache::insert(const QmVideoFrame& frame)
+{
+    if (frame.isNull() || frame.frameNumber() < 0) {
+        return;
+    }
+    std::scoped_lock lock(mutex_);
+    const qint64 bytes = frame.byteSize();
+    if (budget_ <= 0 || bytes > budget_) {
+        return;
+    }
+    auto it = lookup_.find(frame.frameNumber());
+    if (it != lookup_.end()) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+    entries_.push_front({ frame.frameNumber(), frame, bytes });
+    lookup_[frame.frameNumber()] = entries_.begin();
+    bytes_ += bytes;
+    evict(budget_);
+}
+
+qint64 QmFrameCache::shrink(qint64 bytes)
+{
+    std::scoped_lock lock(mutex_);
+    const qint64 before = bytes_;
+    evict(std::max<qint64>(bytes, 0));
+    return before - bytes_;
+}
+
+void QmFrameCache::clear()
+{
+    std::scoped_lock lock(mutex_);
+    entries_.clear();
+    lookup_.clear();
+    bytes_ = 0;
+}
+
+QmFrameCache::Stats QmFrameCache::stats() const
+{
+    std::scoped_lock lock(mutex_);
+    return { hits_, misses_, bytes_, budget_, static_cast<int>(entries_.size()) };
+}
+
+void QmFrameCache::evict(qint64 budget)
+{
+    while (bytes_ > budget && !entries_.empty()) {
+        bytes_ -= entries_.back().bytes;
+        lookup_.erase(entries_.back().frame_no);
+        entries_.pop_back();
+    }
+}
\ No newline at end of file
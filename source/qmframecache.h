@@ -0,0 +1,50 @@
+#pragma once
+
+#include "qmvideoframe.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+// 以帧号为键的解码帧 LRU 缓存，按字节预算淘汰最久未使用的帧
+class QmFrameCache {
+public:
+    struct Stats {
+        qint64 hits { 0 };
+        qint64 misses { 0 };
+        qint64 bytes { 0 };
+        qint64 budget { 0 };
+        int frames { 0 };
+    };
+
+    // budget <= 0 时关闭缓存
+    void setBudget(qint64 budget);
+    qint64 budget() const;
+    bool isEnabled() const;
+
+    QmVideoFrame find(qint64 frame_no);
+    void insert(const QmVideoFrame& frame);
+    // 淘汰到不超过 bytes，返回释放的字节数
+    qint64 shrink(qint64 bytes);
+    void clear();
+
+    Stats stats() const;
+
+private:
+    void evict(qint64 budget);
+
+private:
+    struct Entry {
+        qint64 frame_no;
+        QmVideoFrame frame;
+        qint64 bytes;
+    };
+
+    mutable std::mutex mutex_;
+    // 表头为最近使用
+    std::list<Entry> entries_;
+    std::unordered_map<qint64, std::list<Entry>::iterator> lookup_;
+    qint64 budget_ { 0 };
+    qint64 bytes_ { 0 };
+    qint64 hits_ { 0 };
+    qint64 misses_ { 0 };
+};
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "qmframepool.h"
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/mem.h>
+}
+
+namespace {
+constexpr int alignUp(int value, int align)
+{
+    return (value + align - 1) / align * align;
+}
+}
+
+struct QmFramePool::Buffer {
+    std::shared_ptr<Usage> usage;
+    qint64 size { 0 };
+};
+
+QmFramePool::~QmFramePool() noexcept
+{
+    release();
+}
+
+void QmFramePool::reset(int format, int width, int height)
+{
+    std::scoped_lock lock(mutex_);
+    if (pool_ && format_ == format && width_ == width && height_ == height) {
+        return;
+    }
+    if (pool_) {
+        av_buffer_pool_uninit(&pool_);
+    }
+    format_ = format;
+    width_ = width;
+    height_ = height;
+    buffer_size_ = 0;
+    if (format < 0 || width <= 0 || height <= 0) {
+        return;
+    }
+
+    // 每个平面的行宽都按 kAlignment 对齐，便于 SIMD 处理
+    if (av_image_fill_linesizes(linesize_, static_cast<AVPixelFormat>(format), alignUp(width, kAlignment)) < 0) {
+        return;
+    }
+    for (int& linesize : linesize_) {
+        linesize = alignUp(linesize, kAlignment);
+    }
+    uint8_t* data[4] {};
+    const int size = av_image_fill_pointers(data, static_cast<AVPixelFormat>(format), height, nullptr, linesize_);
+    if (size <= 0) {
+        return;
+    }
+    buffer_size_ = size + kAlignment;
+    pool_ = av_buffer_pool_init2(buffer_size_, this, &QmFramePool::allocBuffer, nullptr);
+}
+
+void QmFramePool::release()
+{
+    std::scoped_lock lock(mutex_);
+    if (pool_) {
+        av_buffer_pool_uninit(&pool_);
+    }
+    for (const QByteArray& array : std::as_const(byte_arrays_)) {
+        addBytes(-array.size());
+    }
+    byte_arrays_.clear();
+    format_ = -1;
+}
+
+qint64 QmFramePool::trim()
+{
+    std::scoped_lock lock(mutex_);
+    const qint64 before = usage_->bytes;
+    // uninit 立即释放空闲缓冲区，使用中的缓冲区在消费者释放后才扣除
+    if (pool_) {
+        av_buffer_pool_uninit(&pool_);
+        pool_ = av_buffer_pool_init2(buffer_size_, this, &QmFramePool::allocBuffer, nullptr);
+    }
+    // 只释放消费者已全部释放的 QByteArray
+    byte_arrays_.removeIf([this](const QByteArray& array) {
+        if (!array.isDetached()) {
+            return false;
+        }
+        addBytes(-array.size());
+        return true;
+    });
+    return before - usage_->bytes;
+}
+
+AVFrame* QmFramePool::allocFrame()
+{
+    std::scoped_lock lock(mutex_);
+    if (!pool_) {
+        return nullptr;
+    }
+    const qint64 misses = misses_;
+    AVBufferRef* buf = av_buffer_pool_get(pool_);
+    if (!buf) {
+        return nullptr;
+    }
+    if (misses_ == misses) {
+        ++hits_;
+    }
+    AVFrame* frame = av_frame_alloc();
+    frame->format = format_;
+    frame->width = width_;
+    frame->height = height_;
+    frame->buf[0] = buf;
+    av_image_fill_pointers(frame->data, static_cast<AVPixelFormat>(format_), height_, buf->data, linesize_);
+    std::copy(std::begin(linesize_), std::end(linesize_), frame->linesize);
+    return frame;
+}
+
+QByteArray QmFramePool::allocByteArray(qsizetype size, const std::function<void(char*)>& fill)
+{
+    std::scoped_lock lock(mutex_);
+    // 池中的副本引用计数为 1 说明消费者已全部释放，可以原地写入而不触发分离
+    for (QByteArray& array : byte_arrays_) {
+        if (array.size() == size && array.isDetached()) {
+            ++hits_;
+            fill(array.data());
+            return array;
+        }
+    }
+    ++misses_;
+    QByteArray array(size, Qt::Uninitialized);
+    fill(array.data());
+    if (byte_arrays_.size() < kMaxByteArrays) {
+        byte_arrays_.append(array);
+        addBytes(size);
+    } else {
+        // 尺寸变化后旧缓冲区不会再命中，用新尺寸替换一个空闲的旧缓冲区
+        for (QByteArray& stale : byte_arrays_) {
+            if (stale.size() != size && stale.isDetached()) {
+                addBytes(size - stale.size());
+                stale = array;
+                break;
+            }
+        }
+    }
+    return array;
+}
+
+void QmFramePool::takeByteArray(const QByteArray& array)
+{
+    std::scoped_lock lock(mutex_);
+    const qsizetype removed = byte_arrays_.removeIf([&array](const QByteArray& pooled) {
+        return pooled.constData() == array.constData();
+    });
+    if (removed > 0) {
+        addBytes(-array.size());
+    }
+}
+
+void QmFramePool::recycleByteArray(const QByteArray& array)
+{
+    std::scoped_lock lock(mutex_);
+    if (byte_arrays_.size() < kMaxByteArrays) {
+        byte_arrays_.append(array);
+        addBytes(array.size());
+    }
+}
+
+QmFramePool::Stats QmFramePool::stats() const
+{
+    return { hits_, misses_, usage_->bytes, usage_->peak_bytes };
+}
+
+AVBufferRef* QmFramePool::allocBuffer(void* opaque, size_t size)
+{
+    // 由 av_buffer_pool_get 在持有 mutex_ 时调用
+    auto* pool = static_cast<QmFramePool*>(opaque);
+    auto* data = static_cast<uint8_t*>(av_malloc(size));
+    if (!data) {
+        return nullptr;
+    }
+    auto* owner = new Buffer { pool->usage_, static_cast<qint64>(size) };
+    AVBufferRef* buf = av_buffer_create(data, size, &QmFramePool::freeBuffer, owner, 0);
+    if (!buf) {
+        av_free(data);
+        delete owner;
+        return nullptr;
+    }
+    ++pool->misses_;
+    pool->addBytes(owner->size);
+    return buf;
+}
+
+void QmFramePool::freeBuffer(void* opaque, uint8_t* data)
+{
+    auto* owner = static_cast<Buffer*>(opaque);
+    owner->usage->add(-owner->size);
+    av_free(data);
+    delete owner;
+}
+
+void QmFramePool::addBytes(qint64 bytes)
+{
+    usage_->add(bytes);
+}
+
+void QmFramePool::Usage::add(qint64 delta)
+{
+    const qint64 current = bytes += delta;
+    qint64 peak = peak_bytes;
+    while (current > peak && !peak_bytes.compare_exchange_weak(peak, current)) {
+    }
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+struct AVBufferPool;
+struct AVBufferRef;
+struct AVFrame;
+
+// 解码输出缓冲区池
+// 按视频尺寸与输出格式分配整帧缓冲区，消费者释放最后一个引用后缓冲区回到池中复用，
+// 避免每帧数 MB 的 malloc/free
+class QmFramePool {
+public:
+    struct Stats {
+        qint64 hits { 0 };
+        qint64 misses { 0 };
+        // 由池分配、尚未归还系统的字节数（空闲 + 使用中）；release/trim 时仍被引用的缓冲区在最后一个引用释放时扣除
+        qint64 bytes { 0 };
+        qint64 peak_bytes { 0 };
+    };
+
+    // 平面行宽对齐字节数
+    static constexpr int kAlignment = 64;
+    // 最多跟踪的 QByteArray 数量，超出后退化为普通分配
+    static constexpr int kMaxByteArrays = 32;
+
+    QmFramePool() = default;
+    ~QmFramePool() noexcept;
+    Q_DISABLE_COPY_MOVE(QmFramePool)
+
+    // 格式或尺寸变化时重建缓冲池，相同参数时不做任何事
+    void reset(int format, int width, int height);
+    // 释放所有空闲缓冲区，使用中的缓冲区在最后一个引用释放后归还系统
+    void release();
+    // 与 release 相同但保留当前格式与尺寸，之后的 allocFrame 重新分配；返回立即归还系统的字节数
+    qint64 trim();
+
+    // 返回的 AVFrame 由调用方 av_frame_free，缓冲区来自池
+    AVFrame* allocFrame();
+    // 复用引用计数为 1（消费者均已释放）的 QByteArray，fill 在返回前写入数据
+    QByteArray allocByteArray(qsizetype size, const std::function<void(char*)>& fill);
+    // 交出池中与 array 共享数据的副本，之后由调用方判断其何时被释放
+    void takeByteArray(const QByteArray& array);
+    // 归还由 takeByteArray 交出、已不再被引用的数组，池已满时直接释放
+    void recycleByteArray(const QByteArray& array);
+
+    Stats stats() const;
+
+private:
+    // 缓冲区可能比池活得更久，字节计数由池与每个缓冲区共享
+    struct Usage {
+        std::atomic<qint64> bytes { 0 };
+        std::atomic<qint64> peak_bytes { 0 };
+        void add(qint64 bytes);
+    };
+    // 每个缓冲区的释放信息，缓冲区真正归还系统时扣除字节数
+    struct Buffer;
+
+    static AVBufferRef* allocBuffer(void* opaque, size_t size);
+    static void freeBuffer(void* opaque, uint8_t* data);
+    void addBytes(qint64 bytes);
+
+private:
+    mutable std::mutex mutex_;
+    AVBufferPool* pool_ { nullptr };
+    int format_ { -1 };
+    int width_ { 0 };
+    int height_ { 0 };
+    int linesize_[4] {};
+    qint64 buffer_size_ { 0 };
+    QList<QByteArray> byte_arrays_;
+
+    std::atomic<qint64> hits_ { 0 };
+    std::atomic<qint64> misses_ { 0 };
+    std::shared_ptr<Usage> usage_ { std::make_shared<Usage>() };
+};
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "qmframequeue.h"
+#include <algorithm>
+
+void QmFrameQueue::setDepth(int depth)
+{
+    std::scoped_lock lock(mutex_);
+    depth_ = std::max(depth, 1);
+    high_watermark_ = std::clamp(high_watermark_, 1, depth_);
+    low_watermark_ = std::clamp(low_watermark_, 0, high_watermark_ - 1);
+    cv_.notify_all();
+}
+
+void QmFrameQueue::setWatermarks(int low, int high)
+{
+    std::scoped_lock lock(mutex_);
+    high_watermark_ = std::clamp(high, 1, depth_);
+    low_watermark_ = std::clamp(low, 0, high_watermark_ - 1);
+    cv_.notify_all();
+}
+
+int QmFrameQueue::depth() const
+{
+    std::scoped_lock lock(mutex_);
+    return depth_;
+}
+
+int QmFrameQueue::lowWatermark() const
+{
+    std::scoped_lock lock(mutex_);
+    return low_watermark_;
+}
+
+int QmFrameQueue::highWatermark() const
+{
+    std::scoped_lock lock(mutex_);
+    return high_watermark_;
+}
+
+int QmFrameQueue::level() const
+{
+    std::scoped_lock lock(mutex_);
+    return static_cast<int>(frames_.size());
+}
+
+qint64 QmFrameQueue::bytes() const
+{
+    std::scoped_lock lock(mutex_);
+    return bytes_;
+}
+
+quint64 QmFrameQueue::generation() const
+{
+    std::scoped_lock lock(mutex_);
+    return generation_;
+}
+
+bool QmFrameQueue::push(QmQueuedFrame frame, quint64 generation, std::stop_token st)
+{
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, st, [this, generation] {
+        return generation != generation_ || (refilling_ && static_cast<int>(frames_.size()) < depth_);
+    });
+    if (st.stop_requested()) {
+        return false;
+    }
+    // 入队前发生过 clear，该帧已过期，直接丢弃
+    if (generation != generation_) {
+        return true;
+    }
+    bytes_ += frame.bytes;
+    frames_.push_back(std::move(frame));
+    if (static_cast<int>(frames_.size()) >= high_watermark_) {
+        refilling_ = false;
+    }
+    cv_.notify_all();
+    return true;
+}
+
+bool QmFrameQueue::canPush() const
+{
+    std::scoped_lock lock(mutex_);
+    return refilling_ && static_cast<int>(frames_.size()) < depth_;
+}
+
+bool QmFrameQueue::pop(QmQueuedFrame* frame, std::stop_token st)
+{
+    std::function<void()> callback;
+    {
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, st, [this] { return !frames_.empty() || finished_; });
+        if (frames_.empty()) {
+            return false;
+        }
+        *frame = std::move(frames_.front());
+        frames_.pop_front();
+        bytes_ -= frame->bytes;
+        if (!refilling_ && static_cast<int>(frames_.size()) <= low_watermark_) {
+            refilling_ = true;
+            callback = refill_callback_;
+        }
+        cv_.notify_all();
+    }
+    if (callback) {
+        callback();
+    }
+    return true;
+}
+
+void QmFrameQueue::finish()
+{
+    std::scoped_lock lock(mutex_);
+    finished_ = true;
+    cv_.notify_all();
+}
+
+void QmFrameQueue::clear()
+{
+    std::function<void()> callback;
+    {
+        std::scoped_lock lock(mutex_);
+        frames_.clear();
+        bytes_ = 0;
+        refilling_ = true;
+        finished_ = false;
+        ++generation_;
+        callback = refill_callback_;
+        cv_.notify_all();
+    }
+    if (callback) {
+        callback();
+    }
+}
+
+void QmFrameQueue::setRefillCallback(std::function<void()> callback)
+{
+    std::scoped_lock lock(mutex_);
+    refill_callback_ = std::move(callback);
+}
\ No newline at end of file
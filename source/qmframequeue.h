@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QVariant>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+
+struct QmQueuedFrame {
+    QVariant data;
+    qint64 frame_no { 0 };
+    // 相对于视频起点的显示时间（单位：us），未知时为 -1
+    qint64 timestamp { -1 };
+    // 帧数据占用的字节数，用于内存记账
+    qint64 bytes { 0 };
+};
+
+// 解码线程与呈现线程之间的有界预读队列
+// 生产者填充到高水位后暂停，直到消费者取到低水位以下再继续填充，避免每帧都唤醒解码线程
+class QmFrameQueue {
+public:
+    void setDepth(int depth);
+    void setWatermarks(int low, int high);
+    int depth() const;
+    int lowWatermark() const;
+    int highWatermark() const;
+    int level() const;
+    qint64 bytes() const;
+
+    // clear 后代数加一，用于丢弃在 clear 之前解码、之后才入队的旧帧
+    quint64 generation() const;
+
+    bool push(QmQueuedFrame frame, quint64 generation, std::stop_token st);
+    // 当前 push 不会阻塞，即处于填充阶段且未满
+    bool canPush() const;
+    bool pop(QmQueuedFrame* frame, std::stop_token st);
+    // 生产结束，消费者取空队列后 pop 返回 false
+    void finish();
+    void clear();
+    // 回落到低水位或被清空、重新进入填充阶段时在消费者线程中回调（不持有队列锁），
+    // 供没有常驻解码线程的生产者（如共享调度器中的解码任务）重新提交工作
+    void setRefillCallback(std::function<void()> callback);
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::deque<QmQueuedFrame> frames_;
+    qint64 bytes_ { 0 };
+    int depth_ { 8 };
+    int low_watermark_ { 4 };
+    int high_watermark_ { 8 };
+    bool refilling_ { true };
+    bool finished_ { false };
+    quint64 generation_ { 0 };
+    std::function<void()> refill_callback_;
+};
\ No newline at end of file
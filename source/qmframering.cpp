@@ -0,0 +1,72 @@
+#include "qmframering.h"
+#include <algorithm>
+#include <bit>
+#include <thread>
+
+QmFrameRing::QmFrameRing(int capacity)
+{
+    const size_t size = std::bit_ceil(static_cast<size_t>(std::max(capacity, 2)));
+    slots_ = std::make_unique<QmVideoFrame[]>(size);
+    mask_ = size - 1;
+}
+
+int QmFrameRing::capacity() const
+{
+    return static_cast<int>(mask_ + 1);
+}
+
+int QmFrameRing::size() const
+{
+    return static_cast<int>(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+}
+
+bool QmFrameRing::push(const QmVideoFrame& frame)
+{
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ > mask_) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head - cached_tail_ > mask_) {
+            return false;
+        }
+    }
+    slots_[head & mask_] = frame;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool QmFrameRing::pop(QmVideoFrame* frame)
+{
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == cached_head_) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail == cached_head_) {
+            return false;
+        }
+    }
+    // 移出后槽位为空，帧的最后一个引用总在消费者线程释放
+    *frame = std::move(slots_[tail & mask_]);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool QmFrameRing::waitPop(QmVideoFrame* frame, std::chrono::microseconds timeout)
+{
+    constexpr int kSpinCount = 64;
+    constexpr int kYieldCount = 64;
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (int attempt = 0;; ++attempt) {
+        if (pop(frame)) {
+            return true;
+        }
+        if (attempt >= kSpinCount + kYieldCount && std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        if (attempt < kSpinCount) {
+            continue;
+        } else if (attempt < kSpinCount + kYieldCount) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
\ No newline at end of file
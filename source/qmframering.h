@@ -0,0 +1,35 @@
+#pragma once
+
+#include "qmvideoframe.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+// 无锁单生产者/单消费者环形缓冲区
+// push 只能由一个线程调用，pop/waitPop 只能由另一个线程调用；容量向上取整到 2 的幂
+class QmFrameRing {
+public:
+    explicit QmFrameRing(int capacity);
+    Q_DISABLE_COPY_MOVE(QmFrameRing)
+
+    int capacity() const;
+    // 近似值，两端并发读写时仅供参考
+    int size() const;
+
+    bool push(const QmVideoFrame& frame);
+    bool pop(QmVideoFrame* frame);
+    // 为空时依次自旋、让出时间片、短暂休眠，直到取到帧或超时
+    bool waitPop(QmVideoFrame* frame, std::chrono::microseconds timeout);
+
+private:
+    static constexpr size_t kCacheLine = 64;
+
+    std::unique_ptr<QmVideoFrame[]> slots_;
+    size_t mask_ { 0 };
+    // 生产者写 head_，消费者写 tail_，分处不同缓存行避免伪共享
+    alignas(kCacheLine) std::atomic<size_t> head_ { 0 };
+    alignas(kCacheLine) std::atomic<size_t> tail_ { 0 };
+    // 各自缓存对端的位置，只在看似已满/为空时重新读取
+    alignas(kCacheLine) size_t cached_tail_ { 0 };
+    alignas(kCacheLine) size_t cached_head_ { 0 };
+};
\ No newline at end of file
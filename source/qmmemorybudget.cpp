@@ -0,0 +1,203 @@
+#include "qmmemorybudget.h"
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+struct Client {
+    QmMemoryBudget::ClientStats stats;
+    QmMemoryBudget::Reclaimer reclaimer;
+};
+} // namespace
+
+class QmMemoryBudgetPrivate {
+public:
+    // 保护以下成员；回收期间同时持有 enforce_mutex，回调中不持有 mutex
+    mutable std::mutex mutex;
+    std::mutex enforce_mutex;
+    std::unordered_map<int, Client> clients;
+    int next_client { 0 };
+    qint64 budget { 0 };
+    qint64 usage { 0 };
+    qint64 peak_usage { 0 };
+
+    void setUsage(Client& client, const QmMemoryBudget::Usage& usage);
+};
+
+void QmMemoryBudgetPrivate::setUsage(Client& client, const QmMemoryBudget::Usage& usage)
+{
+    this->usage += usage.total() - client.stats.usage.total();
+    peak_usage = std::max(peak_usage, this->usage);
+    client.stats.usage = usage;
+}
+
+qint64 QmMemoryBudget::Usage::total() const
+{
+    return std::accumulate(std::begin(bytes), std::end(bytes), qint64 { 0 });
+}
+
+QmMemoryBudget::QmMemoryBudget()
+    : d_(new QmMemoryBudgetPrivate)
+{
+}
+
+QmMemoryBudget::~QmMemoryBudget() noexcept
+{
+    delete d_;
+}
+
+QmMemoryBudget* QmMemoryBudget::instance()
+{
+    static QmMemoryBudget budget;
+    return &budget;
+}
+
+void QmMemoryBudget::setBudget(qint64 bytes)
+{
+    {
+        std::scoped_lock lock(d_->mutex);
+        d_->budget = std::max<qint64>(bytes, 0);
+    }
+    enforce();
+}
+
+qint64 QmMemoryBudget::budget() const
+{
+    std::scoped_lock lock(d_->mutex);
+    return d_->budget;
+}
+
+qint64 QmMemoryBudget::usage() const
+{
+    std::scoped_lock lock(d_->mutex);
+    return d_->usage;
+}
+
+qint64 QmMemoryBudget::peakUsage() const
+{
+    std::scoped_lock lock(d_->mutex);
+    return d_->peak_usage;
+}
+
+qint64 QmMemoryBudget::headroom() const
+{
+    std::scoped_lock lock(d_->mutex);
+    return d_->budget > 0 ? d_->budget - d_->usage : std::numeric_limits<qint64>::max();
+}
+
+int QmMemoryBudget::registerClient(const QString& name, int priority, Reclaimer reclaimer)
+{
+    std::scoped_lock lock(d_->mutex);
+    const int id = d_->next_client++;
+    Client& client = d_->clients[id];
+    client.stats.client = id;
+    client.stats.name = name;
+    client.stats.priority = priority;
+    client.reclaimer = std::move(reclaimer);
+    return id;
+}
+
+void QmMemoryBudget::unregisterClient(int client)
+{
+    std::scoped_lock lock(d_->enforce_mutex, d_->mutex);
+    auto it = d_->clients.find(client);
+    if (it == d_->clients.end()) {
+        return;
+    }
+    d_->usage -= it->second.stats.usage.total();
+    d_->clients.erase(it);
+}
+
+void QmMemoryBudget::setPriority(int client, int priority)
+{
+    std::scoped_lock lock(d_->mutex);
+    auto it = d_->clients.find(client);
+    if (it != d_->clients.end()) {
+        it->second.stats.priority = priority;
+    }
+}
+
+void QmMemoryBudget::report(int client, const Usage& usage)
+{
+    {
+        std::scoped_lock lock(d_->mutex);
+        auto it = d_->clients.find(client);
+        if (it == d_->clients.end()) {
+            return;
+        }
+        d_->setUsage(it->second, usage);
+        if (d_->budget <= 0 || d_->usage <= d_->budget) {
+            return;
+        }
+    }
+    enforce();
+}
+
+QList<QmMemoryBudget::ClientStats> QmMemoryBudget::clients() const
+{
+    QList<ClientStats> result;
+    std::scoped_lock lock(d_->mutex);
+    for (const auto& [id, client] : d_->clients) {
+        result.append(client.stats);
+    }
+    std::sort(result.begin(), result.end(), [](const ClientStats& a, const ClientStats& b) { return a.client < b.client; });
+    return result;
+}
+
+QmMemoryBudget::ClientStats QmMemoryBudget::clientStats(int client) const
+{
+    std::scoped_lock lock(d_->mutex);
+    auto it = d_->clients.find(client);
+    return it == d_->clients.end() ? ClientStats() : it->second.stats;
+}
+
+void QmMemoryBudget::enforce()
+{
+    // 同一时间只有一个线程回收，其他线程的上报不等待
+    std::unique_lock enforce_lock(d_->enforce_mutex, std::try_to_lock);
+    if (!enforce_lock.owns_lock()) {
+        return;
+    }
+    struct Candidate {
+        int client;
+        int priority;
+        qint64 bytes;
+        Reclaimer reclaimer;
+    };
+    std::vector<Candidate> candidates;
+    qint64 excess = 0;
+    {
+        std::scoped_lock lock(d_->mutex);
+        excess = d_->usage - d_->budget;
+        if (d_->budget <= 0 || excess <= 0) {
+            return;
+        }
+        for (const auto& [id, client] : d_->clients) {
+            if (client.reclaimer && client.stats.usage.total() > 0) {
+                candidates.push_back({ id, client.stats.priority, client.stats.usage.total(), client.reclaimer });
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.priority != b.priority ? a.priority < b.priority : a.bytes > b.bytes;
+    });
+    for (const Candidate& candidate : candidates) {
+        // 注销需要 enforce_mutex，回调期间该路不会被移除
+        const Usage usage = candidate.reclaimer(excess);
+        std::scoped_lock lock(d_->mutex);
+        Client& client = d_->clients[candidate.client];
+        const qint64 freed = client.stats.usage.total() - usage.total();
+        d_->setUsage(client, usage);
+        if (freed > 0) {
+            client.stats.reclaimed_bytes += freed;
+            ++client.stats.reclaim_count;
+        }
+        excess = d_->usage - d_->budget;
+        if (excess <= 0) {
+            break;
+        }
+    }
+}
\ No newline at end of file
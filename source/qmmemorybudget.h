@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QtGlobal>
+#include <functional>
+
+#include "qmvideo_global.h"
+
+class QmMemoryBudgetPrivate;
+
+// 进程级内存记账：各解码器按类别上报解码帧、缓冲池、缓存与队列占用的字节数
+// 设置硬预算后，上报使总量超出预算时在上报线程中按优先级从低到高调用各路的回收回调，
+// 同一优先级先回收占用最多的一路，直到回到预算以内
+class QMVIDEO_LIB_EXPORT QmMemoryBudget {
+public:
+    enum Category {
+        // 解码器内部的参考帧与多线程帧缓冲（按尺寸与线程数估算）
+        CodecBuffers,
+        // 格式转换的输出缓冲池（含使用中的缓冲区）
+        FramePool,
+        // readFrame 的解码帧缓存
+        FrameCache,
+        // 预读队列中已解码、待呈现的帧
+        LookaheadQueue,
+        // 解复用后待解码的 packet
+        PacketQueue,
+        CategoryCount,
+    };
+
+    // 按上界统计：预读队列中的帧可能来自缓冲池，不同类别可能引用同一块内存
+    struct Usage {
+        qint64 bytes[CategoryCount] {};
+        qint64 total() const;
+    };
+
+    struct ClientStats {
+        int client { -1 };
+        QString name;
+        int priority { 0 };
+        Usage usage;
+        // 被预算回收的累计字节数与次数
+        qint64 reclaimed_bytes { 0 };
+        qint64 reclaim_count { 0 };
+    };
+
+    // 尽量释放 bytes 字节并返回回收后的占用；在持有预算锁的线程中调用，回调中不能再调用 report
+    using Reclaimer = std::function<Usage(qint64 bytes)>;
+
+    QmMemoryBudget();
+    ~QmMemoryBudget() noexcept;
+    Q_DISABLE_COPY_MOVE(QmMemoryBudget)
+
+    // 进程内共享的实例，解码器在 open 时自动注册
+    static QmMemoryBudget* instance();
+
+    // bytes <= 0 表示不限制（默认），设置后立即按新预算回收
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    qint64 usage() const;
+    qint64 peakUsage() const;
+    // 预算剩余字节数，不限制时为 INT64_MAX
+    qint64 headroom() const;
+
+    // priority 越大越重要，越晚被回收
+    int registerClient(const QString& name, int priority, Reclaimer reclaimer);
+    // 等待正在进行的回收结束后注销，之后不会再调用其回收回调
+    void unregisterClient(int client);
+    void setPriority(int client, int priority);
+    // 上报该路当前的占用，总量超出预算时触发回收；其他线程正在回收时直接返回
+    void report(int client, const Usage& usage);
+
+    QList<ClientStats> clients() const;
+    ClientStats clientStats(int client) const;
+
+private:
+    void enforce();
+
+private:
+    QmMemoryBudgetPrivate* d_ { nullptr };
+};
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "qmpacketqueue.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+QmPacketQueue::~QmPacketQueue() noexcept
+{
+    clearPackets();
+}
+
+void QmPacketQueue::setLimits(int max_packets, qint64 max_bytes)
+{
+    std::scoped_lock lock(mutex_);
+    max_packets_ = std::max(max_packets, 1);
+    max_bytes_ = std::max<qint64>(max_bytes, 1);
+    cv_.notify_all();
+}
+
+int QmPacketQueue::maxPackets() const
+{
+    std::scoped_lock lock(mutex_);
+    return max_packets_;
+}
+
+qint64 QmPacketQueue::maxBytes() const
+{
+    std::scoped_lock lock(mutex_);
+    return max_bytes_;
+}
+
+int QmPacketQueue::count() const
+{
+    std::scoped_lock lock(mutex_);
+    return static_cast<int>(packets_.size());
+}
+
+qint64 QmPacketQueue::bytes() const
+{
+    std::scoped_lock lock(mutex_);
+    return bytes_;
+}
+
+quint64 QmPacketQueue::generation() const
+{
+    std::scoped_lock lock(mutex_);
+    return generation_;
+}
+
+bool QmPacketQueue::push(AVPacket* packet, quint64 generation, std::stop_token st)
+{
+    std::unique_lock lock(mutex_);
+    // 队列为空时总是允许入队，避免单个超大 packet 永远无法入队
+    cv_.wait(lock, st, [this, generation] {
+        return aborted_ || generation != generation_ || packets_.empty()
+            || (static_cast<int>(packets_.size()) < max_packets_ && bytes_ < max_bytes_);
+    });
+    if (st.stop_requested() || aborted_ || generation != generation_) {
+        av_packet_free(&packet);
+        return !st.stop_requested() && !aborted_;
+    }
+    bytes_ += packet->size;
+    packets_.push_back(packet);
+    cv_.notify_all();
+    return true;
+}
+
+bool QmPacketQueue::pop(AVPacket* packet, std::stop_token st)
+{
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, st, [this] { return aborted_ || finished_ || !packets_.empty(); });
+    if (st.stop_requested() || aborted_ || packets_.empty()) {
+        return false;
+    }
+    AVPacket* front = packets_.front();
+    packets_.pop_front();
+    bytes_ -= front->size;
+    av_packet_move_ref(packet, front);
+    av_packet_free(&front);
+    cv_.notify_all();
+    return true;
+}
+
+bool QmPacketQueue::isFinished() const
+{
+    std::scoped_lock lock(mutex_);
+    return finished_ && packets_.empty();
+}
+
+void QmPacketQueue::finish(quint64 generation)
+{
+    std::scoped_lock lock(mutex_);
+    if (generation == generation_) {
+        finished_ = true;
+        cv_.notify_all();
+    }
+}
+
+bool QmPacketQueue::waitForClear(quint64 generation, std::stop_token st)
+{
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, st, [this, generation] { return aborted_ || generation != generation_; });
+    return !st.stop_requested() && !aborted_;
+}
+
+void QmPacketQueue::abort()
+{
+    std::scoped_lock lock(mutex_);
+    aborted_ = true;
+    cv_.notify_all();
+}
+
+void QmPacketQueue::clear()
+{
+    std::scoped_lock lock(mutex_);
+    clearPackets();
+    finished_ = false;
+    ++generation_;
+    cv_.notify_all();
+}
+
+void QmPacketQueue::reset()
+{
+    std::scoped_lock lock(mutex_);
+    clearPackets();
+    finished_ = false;
+    aborted_ = false;
+    ++generation_;
+    cv_.notify_all();
+}
+
+void QmPacketQueue::clearPackets()
+{
+    for (AVPacket* packet : packets_) {
+        av_packet_free(&packet);
+    }
+    packets_.clear();
+    bytes_ = 0;
+}
\ No newline at end of file
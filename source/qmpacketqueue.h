@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QtGlobal>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stop_token>
+
+struct AVPacket;
+
+// 解复用线程与解码线程之间的有界 packet 队列，同时按包数与字节数限流
+class QmPacketQueue {
+public:
+    QmPacketQueue() = default;
+    ~QmPacketQueue() noexcept;
+    Q_DISABLE_COPY_MOVE(QmPacketQueue)
+
+    void setLimits(int max_packets, qint64 max_bytes);
+    int maxPackets() const;
+    qint64 maxBytes() const;
+    int count() const;
+    qint64 bytes() const;
+
+    // clear 后代数加一，用于丢弃 seek 之前读出、之后才入队的旧 packet
+    quint64 generation() const;
+
+    // 取得 packet 的所有权；队列满时阻塞
+    bool push(AVPacket* packet, quint64 generation, std::stop_token st);
+    // 将队首 packet 移入 packet；队列已结束、被中止或 st 请求停止时返回 false
+    bool pop(AVPacket* packet, std::stop_token st = {});
+    bool isFinished() const;
+    // 解复用到达文件末尾
+    void finish(quint64 generation);
+    // 阻塞直到 clear 被调用（例如循环播放时 seek 回开头）
+    bool waitForClear(quint64 generation, std::stop_token st);
+    // 唤醒并中止所有阻塞的 push/pop，直到下一次 reset
+    void abort();
+    // 丢弃已入队的 packet（如 seek），不解除 abort
+    void clear();
+    // 开始新的流水线：clear 并解除 abort
+    void reset();
+
+private:
+    void clearPackets();
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::deque<AVPacket*> packets_;
+    int max_packets_ { 256 };
+    qint64 max_bytes_ { 16 * 1024 * 1024 };
+    qint64 bytes_ { 0 };
+    bool finished_ { false };
+    bool aborted_ { false };
+    quint64 generation_ { 0 };
+};
\ No newline at end of file
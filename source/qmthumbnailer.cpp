@@ -0,0 +1,166 @@
+#include "qmthumbnailer.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+namespace {
+class ThumbnailWorker {
+public:
+    ThumbnailWorker() = default;
+    ~ThumbnailWorker() noexcept;
+    Q_DISABLE_COPY_MOVE(ThumbnailWorker)
+
+    bool open(const QString& video_path, int stream_index, const QSize& size);
+    QImage grab(qint64 pts, const QSize& size);
+
+private:
+    AVFormatContext* fmt_ctx_ { nullptr };
+    AVCodecContext* codec_ctx_ { nullptr };
+    AVPacket* packet_ { nullptr };
+    AVFrame* frame_ { nullptr };
+    SwsContext* sws_ctx_ { nullptr };
+    int stream_index_ { -1 };
+};
+
+ThumbnailWorker::~ThumbnailWorker() noexcept
+{
+    sws_freeContext(sws_ctx_);
+    av_frame_free(&frame_);
+    av_packet_free(&packet_);
+    avcodec_free_context(&codec_ctx_);
+    avformat_close_input(&fmt_ctx_);
+}
+
+bool ThumbnailWorker::open(const QString& video_path, int stream_index, const QSize& size)
+{
+    if (avformat_open_input(&fmt_ctx_, video_path.toStdString().c_str(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx_, nullptr) < 0 || stream_index < 0 || stream_index >= static_cast<int>(fmt_ctx_->nb_streams)) {
+        return false;
+    }
+    for (unsigned i = 0; i < fmt_ctx_->nb_streams; ++i) {
+        if (static_cast<int>(i) != stream_index) {
+            fmt_ctx_->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+    stream_index_ = stream_index;
+
+    const AVCodecParameters* codecpar = fmt_ctx_->streams[stream_index]->codecpar;
+    const AVCodec* codec = avcodec_find_decoder(codecpar->codec_id);
+    if (!codec) {
+        return false;
+    }
+    codec_ctx_ = avcodec_alloc_context3(codec);
+    if (!codec_ctx_ || avcodec_parameters_to_context(codec_ctx_, codecpar) < 0) {
+        return false;
+    }
+    // 在不小于目标尺寸的前提下尽量降低解码分辨率
+    int lowres = 0;
+    while (lowres < codec->max_lowres && (codecpar->width >> (lowres + 1)) >= size.width()
+        && (codecpar->height >> (lowres + 1)) >= size.height()) {
+        ++lowres;
+    }
+    codec_ctx_->lowres = lowres;
+    codec_ctx_->skip_frame = AVDISCARD_NONKEY;
+    // 并行度来自多个 worker，单个解码器不再开线程
+    codec_ctx_->thread_count = 1;
+    if (avcodec_open2(codec_ctx_, codec, nullptr) < 0) {
+        return false;
+    }
+    packet_ = av_packet_alloc();
+    frame_ = av_frame_alloc();
+    return packet_ && frame_;
+}
+
+QImage ThumbnailWorker::grab(qint64 pts, const QSize& size)
+{
+    if (av_seek_frame(fmt_ctx_, stream_index_, pts, AVSEEK_FLAG_BACKWARD) < 0) {
+        return {};
+    }
+    avcodec_flush_buffers(codec_ctx_);
+
+    // seek 落在目标之前的关键帧上，只送入关键帧，之后 flush 取出有重排延迟的解码器中的帧
+    bool decoded = false;
+    while (!decoded && av_read_frame(fmt_ctx_, packet_) >= 0) {
+        const bool key = packet_->stream_index == stream_index_ && (packet_->flags & AV_PKT_FLAG_KEY);
+        if (key && avcodec_send_packet(codec_ctx_, packet_) >= 0) {
+            int ret = avcodec_receive_frame(codec_ctx_, frame_);
+            if (ret == AVERROR(EAGAIN)) {
+                avcodec_send_packet(codec_ctx_, nullptr);
+                ret = avcodec_receive_frame(codec_ctx_, frame_);
+            }
+            decoded = ret >= 0;
+            if (!decoded) {
+                // 关键帧损坏，退出 flush 状态后尝试下一个关键帧
+                avcodec_flush_buffers(codec_ctx_);
+            }
+        }
+        av_packet_unref(packet_);
+    }
+    if (!decoded) {
+        return {};
+    }
+
+    QImage image;
+    sws_ctx_ = sws_getCachedContext(sws_ctx_, frame_->width, frame_->height, static_cast<AVPixelFormat>(frame_->format),
+        size.width(), size.height(), AV_PIX_FMT_RGB24, SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (sws_ctx_) {
+        image = QImage(size, QImage::Format_RGB888);
+        uint8_t* dst_data[4] { image.bits(), nullptr, nullptr, nullptr };
+        const int dst_linesize[4] { static_cast<int>(image.bytesPerLine()), 0, 0, 0 };
+        if (sws_scale(sws_ctx_, frame_->data, frame_->linesize, 0, frame_->height, dst_data, dst_linesize) <= 0) {
+            image = QImage();
+        }
+    }
+    av_frame_unref(frame_);
+    return image;
+}
+}
+
+QList<QImage> QmThumbnailer::extract(const QString& video_path, int stream_index, const QList<qint64>& pts_list, const QSize& size,
+    int thread_count)
+{
+    if (pts_list.isEmpty() || size.isEmpty()) {
+        return QList<QImage>(pts_list.size());
+    }
+    QElapsedTimer elapsed_timer;
+    elapsed_timer.start();
+
+    if (thread_count <= 0) {
+        thread_count = QThread::idealThreadCount();
+    }
+    const qsizetype worker_count = std::clamp<qsizetype>(thread_count, 1, pts_list.size());
+    // 各 worker 只写入自己负责的元素，不能用会检查分离的 QList::operator[]
+    std::vector<QImage> images(pts_list.size());
+    // 每个 worker 处理连续的一段位置，seek 方向一致，读取局部性更好
+    QThreadPool pool;
+    pool.setMaxThreadCount(static_cast<int>(worker_count));
+    for (qsizetype w = 0; w < worker_count; ++w) {
+        const qsizetype begin = pts_list.size() * w / worker_count;
+        const qsizetype end = pts_list.size() * (w + 1) / worker_count;
+        pool.start([&, begin, end] {
+            ThumbnailWorker worker;
+            if (!worker.open(video_path, stream_index, size)) {
+                return;
+            }
+            for (qsizetype i = begin; i < end; ++i) {
+                images[i] = worker.grab(pts_list[i], size);
+            }
+        });
+    }
+    pool.waitForDone();
+
+    qDebug() << "QmThumbnailer::extract. count:" << pts_list.size() << "workers:" << worker_count
+             << "elapsed:" << elapsed_timer.elapsed() << "ms";
+    return QList<QImage>(images.begin(), images.end());
+}
\ No newline at end of file
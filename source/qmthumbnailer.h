@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+// 缩略图提取
+// 每个工作线程独立打开一份解复用与解码上下文，只解码目标位置附近的关键帧，
+// 解码器支持时以 lowres 在解码阶段降采样，再一次 sws_scale 缩放到目标尺寸
+class QmThumbnailer {
+public:
+    // pts_list 为视频流时间基下的目标位置，结果与其一一对应，失败的位置为空 QImage
+    // thread_count <= 0 时使用 QThread::idealThreadCount
+    static QList<QImage> extract(const QString& video_path, int stream_index, const QList<qint64>& pts_list, const QSize& size,
+        int thread_count = 0);
+};
\ No newline at end of file
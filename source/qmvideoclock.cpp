@@ -0,0 +1,57 @@
+#include "qmvideoclock.h"
+#include <cmath>
+
+qint64 QmVideoClock::time() const
+{
+    std::scoped_lock lock(mutex_);
+    return timeAt(Clock::now());
+}
+
+void QmVideoClock::setTime(qint64 time_us)
+{
+    std::scoped_lock lock(mutex_);
+    base_time_ = Clock::now();
+    base_us_ = time_us;
+}
+
+double QmVideoClock::rate() const
+{
+    std::scoped_lock lock(mutex_);
+    return rate_;
+}
+
+void QmVideoClock::setRate(double rate)
+{
+    std::scoped_lock lock(mutex_);
+    const auto now = Clock::now();
+    base_us_ = timeAt(now);
+    base_time_ = now;
+    rate_ = rate;
+}
+
+bool QmVideoClock::isPaused() const
+{
+    std::scoped_lock lock(mutex_);
+    return paused_;
+}
+
+void QmVideoClock::setPaused(bool paused)
+{
+    std::scoped_lock lock(mutex_);
+    if (paused_ == paused) {
+        return;
+    }
+    const auto now = Clock::now();
+    base_us_ = timeAt(now);
+    base_time_ = now;
+    paused_ = paused;
+}
+
+qint64 QmVideoClock::timeAt(Clock::time_point now) const
+{
+    if (paused_) {
+        return base_us_;
+    }
+    const auto elapsed_us = std::chrono::duration<double, std::micro>(now - base_time_).count();
+    return base_us_ + std::llround(elapsed_us * rate_);
+}
\ No newline at end of file
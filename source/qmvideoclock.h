@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QtGlobal>
+#include <chrono>
+#include <mutex>
+
+#include "qmvideo_global.h"
+
+// 呈现时钟（单位：us），以 rate 倍速随单调时钟推进，暂停时停止
+// 解码器默认使用内部时钟；作为外部时钟时（如音频时钟）由调用方持续 setTime 校准，解码器只读取
+class QMVIDEO_LIB_EXPORT QmVideoClock {
+public:
+    qint64 time() const;
+    void setTime(qint64 time_us);
+    // rate 为负时时钟倒退，修改 rate 不改变当前时间
+    double rate() const;
+    void setRate(double rate);
+    bool isPaused() const;
+    void setPaused(bool paused);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    qint64 timeAt(Clock::time_point now) const;
+
+private:
+    mutable std::mutex mutex_;
+    Clock::time_point base_time_ { Clock::now() };
+    qint64 base_us_ { 0 };
+    double rate_ { 1.0 };
+    bool paused_ { false };
+};
\ No newline at end of file
@@ -1,44 +1,268 @@
 #include "qmvideodecoder.h"
+#include "qmdecoderscheduler.h"
+#include "qmdeliverytracker.h"
+#include "qmframecache.h"
+#include "qmframepool.h"
+#include "qmframering.h"
+#include "qmframequeue.h"
+#include "qmmemorybudget.h"
+#include "qmpacketqueue.h"
+#include "qmthumbnailer.h"
+#include "qmvideoclock.h"
+#include "qmvideoframe.h"
+#include "qmvideoindex.h"
+#include "qmyuvconvert.h"
 #include <QDebug>
 #include <QFile>
 #include <QImage>
 #include <QSize>
 #include <QThread>
 #include <QTimer>
+#include <algorithm>
 #include <chrono>
+#include <deque>
+#include <unordered_map>
+#include <thread>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libswresample/swresample.h>
 #include <libswscale/swscale.h>
 }
 
 namespace {
-QByteArray decodeToYuv(AVFrame* frame, int width, int height)
+bool isYuv420pLayout(int format)
 {
-    int y_size = width * height;
-    int uv_size = (width / 2) * (height / 2);
-    QByteArray yuv_data;
-    yuv_data.resize(width * height * 3 / 2, 0);
-    std::copy_n(frame->data[0], y_size, yuv_data.data());
-    std::copy_n(frame->data[1], uv_size, yuv_data.data() + y_size);
-    std::copy_n(frame->data[2], uv_size, yuv_data.data() + y_size + uv_size);
-    return yuv_data;
+    return format == AV_PIX_FMT_YUV420P || format == AV_PIX_FMT_YUVJ420P;
 }
 
-QImage decodeToImage(SwsContext* sws_ctx, AVFrame* frame, AVFrame* rgb_frame, uint8_t* rgb_buffer, int width, int height)
+// 按 linesize 逐行拷贝，frame 的宽度不等于行宽（对齐填充、奇数宽度）时同样正确
+QByteArray decodeToYuv(const AVFrame* frame, QmFramePool& pool)
 {
-    if (sws_scale(sws_ctx, frame->data, frame->linesize, 0, height, rgb_frame->data, rgb_frame->linesize) > 0) {
+    const int size = av_image_get_buffer_size(AV_PIX_FMT_YUV420P, frame->width, frame->height, 1);
+    if (size <= 0) {
+        return {};
+    }
+    return pool.allocByteArray(size, [frame, size](char* data) {
+        av_image_copy_to_buffer(reinterpret_cast<uint8_t*>(data), size, frame->data, frame->linesize, AV_PIX_FMT_YUV420P, frame->width, frame->height, 1);
+    });
+}
 
-        QImage img(rgb_frame->data[0], width, height, rgb_frame->linesize[0], QImage::Format_RGB888);
+// QImage 直接引用 frame 的缓冲区，QImage 及其所有副本析构后缓冲区才归还到池中
+QImage wrapImage(const QmVideoFrame& frame, QImage::Format format)
+{
+    if (frame.isNull()) {
+        return {};
+    }
+    auto* holder = new QmVideoFrame(frame);
+    return QImage(frame.constBits(0), frame.width(), frame.height(), frame.bytesPerLine(0), format,
+        [](void* info) { delete static_cast<QmVideoFrame*>(info); }, holder);
+}
 
-        if (!img.isNull()) {
-            return img.copy();
-        }
+QImage decodeToImage(SwsContext* sws_ctx, const AVFrame* frame, QmFramePool& pool, QImage::Format format, qint64 frame_no, qint64 timestamp)
+{
+    AVFrame* rgb_frame = pool.allocFrame();
+    if (!rgb_frame) {
+        return {};
+    }
+    QImage img;
+    if (sws_scale(sws_ctx, frame->data, frame->linesize, 0, frame->height, rgb_frame->data, rgb_frame->linesize) > 0) {
+        img = wrapImage(QmVideoFrame(rgb_frame, frame_no, timestamp), format);
+    }
+    av_frame_free(&rgb_frame);
+    return img;
+}
+
+QmYuvConvert::ColorSpace colorSpaceOf(const AVFrame* frame)
+{
+    return frame->colorspace == AVCOL_SPC_BT709 ? QmYuvConvert::Bt709 : QmYuvConvert::Bt601;
+}
+
+QmYuvConvert::ColorRange colorRangeOf(const AVFrame* frame)
+{
+    return (frame->color_range == AVCOL_RANGE_JPEG || frame->format == AV_PIX_FMT_YUVJ420P) ? QmYuvConvert::FullRange : QmYuvConvert::LimitedRange;
+}
+
+// 同尺寸 yuv420p 到 RGB 使用 QmYuvConvert，直接写入池中的缓冲区
+QImage convertToImage(const AVFrame* frame, QmFramePool& pool, QmYuvConvert::PixelFormat pixel_format, QImage::Format format, qint64 frame_no,
+    qint64 timestamp)
+{
+    AVFrame* rgb_frame = pool.allocFrame();
+    if (!rgb_frame) {
+        return {};
+    }
+    QmYuvConvert::convert(frame->data, frame->linesize, rgb_frame->data[0], rgb_frame->linesize[0], frame->width, frame->height, pixel_format,
+        colorSpaceOf(frame), colorRangeOf(frame));
+    QImage img = wrapImage(QmVideoFrame(rgb_frame, frame_no, timestamp), format);
+    av_frame_free(&rgb_frame);
+    return img;
+}
+
+// swscale 默认按 BT.601 转换，与 QmYuvConvert 保持一致的色彩空间与范围
+// sws_setColorspaceDetails 会重建转换表，只在新建的转换器或源的色彩空间、范围变化时设置；
+// 其余参数即新建转换器的默认值，RGB 输出的目标范围由 swscale 固定
+void setSwsColorspace(SwsContext* sws_ctx, const AVFrame* frame)
+{
+    const int* src_table = sws_getCoefficients(colorSpaceOf(frame) == QmYuvConvert::Bt709 ? SWS_CS_ITU709 : SWS_CS_ITU601);
+    const int src_range = colorRangeOf(frame) == QmYuvConvert::FullRange ? 1 : 0;
+    int* cur_src_table = nullptr;
+    int* cur_dst_table = nullptr;
+    int cur_src_range = 0;
+    int cur_dst_range = 0;
+    int brightness = 0;
+    int contrast = 0;
+    int saturation = 0;
+    if (sws_getColorspaceDetails(sws_ctx, &cur_src_table, &cur_src_range, &cur_dst_table, &cur_dst_range, &brightness, &contrast, &saturation) >= 0
+        && cur_src_range == src_range && std::equal(src_table, src_table + 4, cur_src_table)) {
+        return;
+    }
+    sws_setColorspaceDetails(sws_ctx, src_table, src_range, sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+}
+
+// seek 需要清空解码器并重新读取 packet，按解码若干帧估算其代价
+constexpr qint64 kSeekCostFrames = 4;
+// 没有索引时无法得知 GOP 长度，只在小步长时向前解码
+constexpr qint64 kMaxForwardFrames = 8;
+
+// 呈现时钟的最长单次等待，期间时钟可能被外部校准或暂停
+constexpr qint64 kMaxClockWaitUs = 20000;
+// 晚于呈现时刻超过该值计为迟到
+constexpr qint64 kLateToleranceUs = 5000;
+// 等待消费者释放在途帧时的轮询间隔
+constexpr qint64 kDeliveryPollUs = 2000;
+// 播放结束时等待发出暂存帧的最长时间
+constexpr qint64 kFinalFlushTimeoutUs = 500000;
+// 调度器中的单个解码任务最多解码的帧数，之后让出工作线程给截止时间更早的流
+constexpr int kScheduledBatchFrames = 4;
+
+qint64 byteSizeOf(const QVariant& data)
+{
+    const QMetaType type = data.metaType();
+    if (type == QMetaType::fromType<QmVideoFrame>()) {
+        return data.value<QmVideoFrame>().byteSize();
+    }
+    if (type == QMetaType::fromType<QImage>()) {
+        return data.value<QImage>().sizeInBytes();
+    }
+    if (type == QMetaType::fromType<QByteArray>()) {
+        return data.toByteArray().size();
+    }
+    return 0;
+}
+
+// 输出为 QImage 的格式，像素格式与 QImage 格式的内存布局一致，绘制时无需再次转换
+bool imageFormatOf(QmVideoDecoder::Format format, AVPixelFormat* pix_fmt, QImage::Format* image_format)
+{
+    switch (format) {
+    case QmVideoDecoder::Image:
+        *pix_fmt = AV_PIX_FMT_RGB24;
+        *image_format = QImage::Format_RGB888;
+        return true;
+    case QmVideoDecoder::Rgba:
+        *pix_fmt = AV_PIX_FMT_RGBA;
+        *image_format = QImage::Format_RGBA8888;
+        return true;
+    case QmVideoDecoder::Bgra:
+        // 按本机字节序的 0xAARRGGBB，小端下即 BGRA
+        *pix_fmt = AV_PIX_FMT_RGB32;
+        *image_format = QImage::Format_ARGB32;
+        return true;
+    case QmVideoDecoder::Gray8:
+        *pix_fmt = AV_PIX_FMT_GRAY8;
+        *image_format = QImage::Format_Grayscale8;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool toYuvConvertFormat(AVPixelFormat pix_fmt, QmYuvConvert::PixelFormat* format)
+{
+    switch (pix_fmt) {
+    case AV_PIX_FMT_RGB24:
+        *format = QmYuvConvert::Rgb24;
+        return true;
+    case AV_PIX_FMT_RGBA:
+        *format = QmYuvConvert::Rgba;
+        return true;
+    case AV_PIX_FMT_BGRA:
+        *format = QmYuvConvert::Bgra;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// 第一个平面为 8 位亮度的 YUV 格式（yuv420p、nv12 等），可直接作为灰度图引用
+bool hasLumaPlane(int format)
+{
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(format));
+    return desc && !(desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_HWACCEL)) && desc->nb_components > 0
+        && desc->comp[0].plane == 0 && desc->comp[0].step == 1 && desc->comp[0].depth == 8;
+}
+
+// 源格式可以不经转换直接输出为 target
+bool isPassthrough(int format, AVPixelFormat target)
+{
+    if (target == AV_PIX_FMT_YUV420P) {
+        return isYuv420pLayout(format);
+    }
+    if (target == AV_PIX_FMT_GRAY8) {
+        return format == AV_PIX_FMT_GRAY8 || hasLumaPlane(format);
+    }
+    return format == target;
+}
+
+// 拉取模式的环形缓冲区只能存放 QmVideoFrame
+bool isFrameFormat(QmVideoDecoder::Format format)
+{
+    return format == QmVideoDecoder::Frame || format == QmVideoDecoder::Yuv420pPlanar || format == QmVideoDecoder::Nv12;
+}
+
+// FFmpeg 在 thread_count = 0 时同样以 16 为上限，超过后 h264 等解码器会给出警告
+constexpr int kMaxAutoThreads = 16;
+
+int resolveThreadCount(int thread_count)
+{
+    if (thread_count > 0) {
+        return thread_count;
+    }
+    return std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, kMaxAutoThreads);
+}
+
+int toSwsFlags(QmVideoDecoder::ScaleAlgorithm algorithm)
+{
+    switch (algorithm) {
+    case QmVideoDecoder::Bilinear:
+        return SWS_BILINEAR;
+    case QmVideoDecoder::Bicubic:
+        return SWS_BICUBIC;
+    case QmVideoDecoder::Area:
+        return SWS_AREA;
+    case QmVideoDecoder::Lanczos:
+        return SWS_LANCZOS;
+    case QmVideoDecoder::Point:
+        return SWS_POINT;
+    default:
+        return SWS_FAST_BILINEAR;
+    }
+}
+
+int toThreadType(QmVideoDecoder::ThreadingMode mode)
+{
+    switch (mode) {
+    case QmVideoDecoder::FrameThreading:
+        return FF_THREAD_FRAME;
+    case QmVideoDecoder::SliceThreading:
+        return FF_THREAD_SLICE;
+    case QmVideoDecoder::NoThreading:
+        return 0;
+    default:
+        return FF_THREAD_FRAME | FF_THREAD_SLICE;
     }
-    return {};
 }
 }
 
@@ -49,32 +273,565 @@ struct QmVideoDecoderPrivate {
     AVFrame* frame { nullptr };
 
     SwsContext* sws_ctx { nullptr };
-    AVFrame* rgb_frame { nullptr };
-    uint8_t* rgb_buffer { nullptr };
+    // 非 yuv420p 源到 yuv420p 的转换器
+    SwsContext* yuv_sws_ctx { nullptr };
+    QmFramePool frame_pool;
+    QmFrameCache frame_cache;
+    // 仅在 readFrame / readFrames 解码时写入帧缓存，播放流水线不写入
+    bool caching { false };
 
     QString video_path;
     double fps { 1 };
+    AVRational time_base { 1, AV_TIME_BASE };
+    int64_t start_pts { 0 };
     // 视频时长（单位：ms）
     double duration { 0 };
     qint64 frame_count { 0 };
     int video_stream_idx = -1;
     QSize video_size { 0, 0 };
     QmVideoDecoder::Format format { QmVideoDecoder::Yuv420p };
+    // 输出几何：为空时分别表示与裁剪区域相同、不裁剪
+    QSize output_size;
+    QRect output_roi;
+    int sws_flags { SWS_FAST_BILINEAR };
+    QmVideoDecoder::IndexMode index_mode { QmVideoDecoder::LazyIndex };
+    QmVideoIndex index;
+    QString index_cache_dir;
+    bool index_attempted { false };
+    // LazyIndex 在后台扫描文件，完成后在 decode_mutex 下替换 index
+    std::jthread index_thread;
+    // 最近一次从解码器取出的帧号（含被丢弃的帧），seek 后为 -1
+    qint64 last_frame_no { -1 };
+    // 精确 seek 的目标 pts，早于该值的帧解码后丢弃
+    int64_t target_pts { AV_NOPTS_VALUE };
+    QmVideoDecoder::ThreadingMode threading_mode { QmVideoDecoder::AutoThreading };
+    int thread_count { 0 };
+    QmDecoderScheduler* scheduler { nullptr };
+    // open 时注册所用的调度器与流 id，close 时注销
+    QmDecoderScheduler* stream_scheduler { nullptr };
+    int stream_id { -1 };
+    // 保证同一路最多只有一个解码任务在调度器中；decode_stopped 与提交在 schedule_mutex 下互斥，停止后不会再提交
+    std::atomic_bool decode_scheduled { false };
+    bool decode_stopped { true };
+    bool decode_trick_play { false };
+    std::mutex schedule_mutex;
+
+    // 在 QmMemoryBudget::instance 中注册的 id，open 时注册、close 时注销
+    int memory_client { -1 };
+    int memory_priority { 0 };
+    // 解码器内部帧缓冲的估算值
+    qint64 codec_bytes { 0 };
+    // 用户设置的预读深度与水位，预算回收缩小深度后据此恢复
+    int lookahead_depth { 8 };
+    int lookahead_low { 4 };
+    int lookahead_high { 8 };
+    std::atomic_bool lookahead_reduced { false };
+    // 倒放时已解码、等待倒序输出的 GOP 帧
+    std::atomic<qint64> reverse_bytes { 0 };
 
     qint64 frame_index { 0 };
     std::atomic<qint64> frame_step { 1 };
     std::atomic_bool loop { false };
+    // 倒放时预取的 GOP 个数
+    std::atomic_int reverse_gop_count { 2 };
+    // 关键帧快进/快退的倍速，<= 1 表示关闭
+    std::atomic_int trick_speed { 1 };
+
+    QmVideoClock internal_clock;
+    // 外部呈现时钟，为空时使用 internal_clock
+    std::atomic<QmVideoClock*> external_clock { nullptr };
+    // 呈现落后于时钟时解码线程跳过非参考帧
+    std::atomic_bool catching_up { false };
+    std::atomic<qint64> presented_count { 0 };
+    std::atomic<qint64> late_count { 0 };
+    std::atomic<qint64> dropped_count { 0 };
+
+    std::atomic<QmVideoDecoder::DeliveryPolicy> delivery_policy { QmVideoDecoder::UnboundedDelivery };
+    QmDeliveryTracker delivery;
+    std::atomic<qint64> backpressure_dropped { 0 };
+    // 拉取模式的环形缓冲区，为空时通过 frameReady 投递
+    std::unique_ptr<QmFrameRing> frame_ring;
+    std::atomic_bool realtime { true };
+
+    QmFrameQueue frame_queue;
+    QmPacketQueue packet_queue;
+    // 播放时由解复用线程读取 packet，否则在调用线程中直接读取
+    std::atomic_bool demuxing { false };
+    // 当前流水线的停止令牌，停止后阻塞在 packet_queue 上的读取立即返回；在 decode_mutex 下读写
+    std::stop_token pipeline_st;
+    // 保护 fmt_ctx，解复用线程与 seek 可能并发访问
+    std::mutex demux_mutex;
 
     QThread* thread { nullptr };
+    // 保护解码上下文，预读线程与 seekToFrame/readFrame 可能并发访问
+    std::mutex decode_mutex;
+    // 保护转换器与输出缓冲池，倒放时转换与 GOP 解码并行；与 decode_mutex 同时持有时后加锁
+    std::mutex convert_mutex;
     std::mutex wait_mutex;
     std::stop_source stop_source;
     QmVideoDecoder::State state { QmVideoDecoder::Idle };
+
+    qint64 frameTimestamp(const AVFrame* frame) const;
+    qint64 frameNumberOf(const AVFrame* frame) const;
+    void ensureIndex();
+    bool loadIndex();
+    QRect cropRect(const QSize& frame_size) const;
+    QSize outputSize(const QSize& crop_size) const;
+    AVFrame* cropFrame(const AVFrame* src) const;
+    void updateConverter();
+    QmVideoFrame planarFrame(const AVFrame* src, AVPixelFormat target, qint64 frame_no, qint64 timestamp);
+    QVariant convertFrame(const AVFrame* src, qint64 frame_no);
+    int readPacket(AVPacket* pkt);
+    int decodeNext(qint64* frame_no);
+    double playbackRate() const;
+    QList<QImage> thumbnails(const QList<qint64>& frame_numbers, const QSize& size);
+    void demuxLoop(std::stop_token st);
+    QmMemoryBudget::Usage memoryUsage() const;
+    QmMemoryBudget::Usage reclaimMemory(qint64 bytes);
+    void reportMemory();
 };
 
+qint64 QmVideoDecoderPrivate::frameTimestamp(const AVFrame* frame) const
+{
+    if (frame->best_effort_timestamp == AV_NOPTS_VALUE) {
+        return -1;
+    }
+    return av_rescale_q(frame->best_effort_timestamp - start_pts, time_base, AVRational { 1, AV_TIME_BASE });
+}
+
+qint64 QmVideoDecoderPrivate::frameNumberOf(const AVFrame* frame) const
+{
+    if (index.isValid() && frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+        return index.frameOfPts(frame->best_effort_timestamp);
+    }
+    const qint64 timestamp_us = frameTimestamp(frame);
+    if (timestamp_us < 0) {
+        return -1;
+    }
+    return std::llround(timestamp_us * fps / AV_TIME_BASE);
+}
+
+void QmVideoDecoderPrivate::ensureIndex()
+{
+    if (index_mode == QmVideoDecoder::NoIndex || index_attempted || video_path.isEmpty()) {
+        return;
+    }
+    index_attempted = true;
+    const QString cache_file = index_cache_dir.isEmpty() ? QString() : QmVideoIndex::cacheFilePath(index_cache_dir, video_path, video_stream_idx);
+    if (index_mode == QmVideoDecoder::IndexOnOpen) {
+        if (index.build(video_path, video_stream_idx)) {
+            frame_count = index.frameCount();
+            if (!cache_file.isEmpty()) {
+                index.save(cache_file);
+            }
+        }
+        return;
+    }
+    // 扫描整个文件耗时与文件大小成正比，不阻塞 seek 与播放；建好之前按帧率估算帧号
+    index_thread = std::jthread([this, path = video_path, stream_idx = video_stream_idx, cache_file](std::stop_token st) {
+        QmVideoIndex built;
+        if (!built.build(path, stream_idx, st)) {
+            return;
+        }
+        if (!cache_file.isEmpty()) {
+            built.save(cache_file);
+        }
+        std::scoped_lock lock(decode_mutex);
+        if (st.stop_requested()) {
+            return;
+        }
+        index = std::move(built);
+        frame_count = index.frameCount();
+        // 估算的帧号与索引帧号可能不一致，下次 seek 不从当前位置向前解码，按估算帧号缓存的帧也不再可用
+        last_frame_no = -1;
+        frame_cache.clear();
+    });
+}
+
+bool QmVideoDecoderPrivate::loadIndex()
+{
+    if (index_mode == QmVideoDecoder::NoIndex || index_cache_dir.isEmpty()) {
+        return false;
+    }
+    if (!index.load(QmVideoIndex::cacheFilePath(index_cache_dir, video_path, video_stream_idx))) {
+        return false;
+    }
+    index_attempted = true;
+    frame_count = index.frameCount();
+    return true;
+}
+
+// 裁剪区域限制在画面内，左上角取偶数使 4:2:0 的色度与亮度对齐
+QRect QmVideoDecoderPrivate::cropRect(const QSize& frame_size) const
+{
+    const QRect frame_rect(QPoint(0, 0), frame_size);
+    if (output_roi.isEmpty()) {
+        return frame_rect;
+    }
+    QRect roi = output_roi.intersected(frame_rect);
+    roi.moveTopLeft(QPoint(roi.x() & ~1, roi.y() & ~1));
+    return roi;
+}
+
+QSize QmVideoDecoderPrivate::outputSize(const QSize& crop_size) const
+{
+    return output_size.isEmpty() ? crop_size : output_size;
+}
+
+// 只调整平面指针与宽高，不拷贝像素数据
+AVFrame* QmVideoDecoderPrivate::cropFrame(const AVFrame* src) const
+{
+    const QRect roi = cropRect(QSize(src->width, src->height));
+    if (roi.isEmpty()) {
+        return nullptr;
+    }
+    AVFrame* frame = av_frame_clone(src);
+    if (!frame) {
+        return nullptr;
+    }
+    frame->crop_left = roi.x();
+    frame->crop_top = roi.y();
+    frame->crop_right = src->width - roi.x() - roi.width();
+    frame->crop_bottom = src->height - roi.y() - roi.height();
+    if (av_frame_apply_cropping(frame, AV_FRAME_CROP_UNALIGNED) < 0) {
+        av_frame_free(&frame);
+    }
+    return frame;
+}
+
+// 根据输出格式与几何参数准备转换器与缓冲池，转换时 sws_getCachedContext 在参数不变时直接复用
+void QmVideoDecoderPrivate::updateConverter()
+{
+    if (!video_codec_ctx) {
+        return;
+    }
+    std::scoped_lock lock(convert_mutex);
+    const QSize crop_size = cropRect(video_size).size();
+    const QSize out_size = outputSize(crop_size);
+    const bool scaled = out_size != crop_size;
+    AVPixelFormat pix_fmt = AV_PIX_FMT_NONE;
+    QImage::Format image_format = QImage::Format_Invalid;
+    if (imageFormatOf(format, &pix_fmt, &image_format)) {
+        if (scaled || !isPassthrough(video_codec_ctx->pix_fmt, pix_fmt)) {
+            sws_ctx = sws_getCachedContext(sws_ctx, crop_size.width(), crop_size.height(), video_codec_ctx->pix_fmt,
+                out_size.width(), out_size.height(), pix_fmt, sws_flags, nullptr, nullptr, nullptr);
+            frame_pool.reset(pix_fmt, out_size.width(), out_size.height());
+        } else {
+            frame_pool.release();
+        }
+    } else if (format == QmVideoDecoder::Frame) {
+        frame_pool.release();
+    } else {
+        const AVPixelFormat planar_fmt = (format == QmVideoDecoder::Nv12) ? AV_PIX_FMT_NV12 : AV_PIX_FMT_YUV420P;
+        if (scaled || !isPassthrough(video_codec_ctx->pix_fmt, planar_fmt)) {
+            frame_pool.reset(planar_fmt, out_size.width(), out_size.height());
+        }
+    }
+}
+
+// 源格式与 target 一致且无需缩放时直接引用解码器缓冲区，否则转换到按 kDefaultAlignment 对齐的新缓冲区
+QmVideoFrame QmVideoDecoderPrivate::planarFrame(const AVFrame* src, AVPixelFormat target, qint64 frame_no, qint64 timestamp)
+{
+    const QSize out_size = outputSize(QSize(src->width, src->height));
+    if (isPassthrough(src->format, target) && out_size == QSize(src->width, src->height)) {
+        return QmVideoFrame(src, frame_no, timestamp);
+    }
+    yuv_sws_ctx = sws_getCachedContext(yuv_sws_ctx, src->width, src->height, static_cast<AVPixelFormat>(src->format),
+        out_size.width(), out_size.height(), target, sws_flags, nullptr, nullptr, nullptr);
+    if (!yuv_sws_ctx) {
+        return {};
+    }
+    frame_pool.reset(target, out_size.width(), out_size.height());
+    AVFrame* dst = frame_pool.allocFrame();
+    if (!dst) {
+        return {};
+    }
+    QmVideoFrame result;
+    if (sws_scale(yuv_sws_ctx, src->data, src->linesize, 0, src->height, dst->data, dst->linesize) > 0) {
+        av_frame_copy_props(dst, src);
+        result = QmVideoFrame(dst, frame_no, timestamp);
+    }
+    av_frame_free(&dst);
+    return result;
+}
+
+// 按输出格式转换解码帧，裁剪与缩放在同一次转换中完成
+QVariant QmVideoDecoderPrivate::convertFrame(const AVFrame* src, qint64 frame_no)
+{
+    std::scoped_lock lock(convert_mutex);
+    const qint64 timestamp = frameTimestamp(src);
+    AVFrame* cropped = nullptr;
+    auto cropped_guard = qScopeGuard([&cropped] {
+        av_frame_free(&cropped);
+    });
+    if (!output_roi.isEmpty()) {
+        cropped = cropFrame(src);
+        if (!cropped) {
+            return {};
+        }
+        src = cropped;
+    }
+
+    const QSize out_size = outputSize(QSize(src->width, src->height));
+    const bool scaled = out_size != QSize(src->width, src->height);
+    AVPixelFormat pix_fmt = AV_PIX_FMT_NONE;
+    QImage::Format image_format = QImage::Format_Invalid;
+    if (format == QmVideoDecoder::Frame) {
+        return QVariant::fromValue(QmVideoFrame(src, frame_no, timestamp));
+    } else if (format == QmVideoDecoder::Yuv420pPlanar) {
+        return QVariant::fromValue(planarFrame(src, AV_PIX_FMT_YUV420P, frame_no, timestamp));
+    } else if (format == QmVideoDecoder::Nv12) {
+        return QVariant::fromValue(planarFrame(src, AV_PIX_FMT_NV12, frame_no, timestamp));
+    } else if (format == QmVideoDecoder::Yuv420p) {
+        if (isYuv420pLayout(src->format) && !scaled) {
+            return decodeToYuv(src, frame_pool);
+        }
+        QmVideoFrame planar = planarFrame(src, AV_PIX_FMT_YUV420P, frame_no, timestamp);
+        return planar.isNull() ? QVariant() : QVariant(decodeToYuv(planar.avFrame(), frame_pool));
+    } else if (imageFormatOf(format, &pix_fmt, &image_format)) {
+        // 格式一致时 QImage 直接引用解码器缓冲区；灰度输出直接引用 YUV 的亮度平面
+        if (!scaled && isPassthrough(src->format, pix_fmt)) {
+            return wrapImage(QmVideoFrame(src, frame_no, timestamp), image_format);
+        }
+        QmYuvConvert::PixelFormat yuv_format;
+        if (!scaled && isYuv420pLayout(src->format) && toYuvConvertFormat(pix_fmt, &yuv_format)) {
+            frame_pool.reset(pix_fmt, out_size.width(), out_size.height());
+            return convertToImage(src, frame_pool, yuv_format, image_format, frame_no, timestamp);
+        }
+        sws_ctx = sws_getCachedContext(sws_ctx, src->width, src->height, static_cast<AVPixelFormat>(src->format),
+            out_size.width(), out_size.height(), pix_fmt, sws_flags, nullptr, nullptr, nullptr);
+        if (!sws_ctx) {
+            return {};
+        }
+        if (isYuv420pLayout(src->format)) {
+            setSwsColorspace(sws_ctx, src);
+        }
+        frame_pool.reset(pix_fmt, out_size.width(), out_size.height());
+        return decodeToImage(sws_ctx, src, frame_pool, image_format, frame_no, timestamp);
+    }
+    return {};
+}
+
+int QmVideoDecoderPrivate::readPacket(AVPacket* pkt)
+{
+    if (!demuxing) {
+        std::scoped_lock lock(demux_mutex);
+        return av_read_frame(fmt_ctx, pkt);
+    }
+    if (packet_queue.pop(pkt, pipeline_st)) {
+        return 0;
+    }
+    return packet_queue.isFinished() ? AVERROR_EOF : AVERROR_EXIT;
+}
+
+// 从解码器取出下一帧到 frame，成功返回 0，否则返回 FFmpeg 错误码
+int QmVideoDecoderPrivate::decodeNext(qint64* frame_no)
+{
+    int ret = 0;
+    int attempt_count = 0;
+
+    // 先取出解码器中已有的帧，再送入新的 packet；帧级多线程或 B 帧时一个 packet 可能对应多帧输出
+    while (attempt_count < 50) {
+        ret = avcodec_receive_frame(video_codec_ctx, frame);
+        if (ret >= 0) {
+            *frame_no = frameNumberOf(frame);
+            last_frame_no = *frame_no;
+            // 包括 seek 途中被丢弃的中间帧，来回拖动时可直接命中
+            if (caching && frame_cache.isEnabled()) {
+                frame_cache.insert(QmVideoFrame(frame, *frame_no, frameTimestamp(frame)));
+            }
+            // 精确 seek：丢弃目标帧之前的帧
+            if (target_pts != AV_NOPTS_VALUE) {
+                if (frame->best_effort_timestamp != AV_NOPTS_VALUE && frame->best_effort_timestamp < target_pts) {
+                    continue;
+                }
+                target_pts = AV_NOPTS_VALUE;
+            }
+            return 0;
+        }
+        // 解码结束
+        if (ret == AVERROR_EOF) {
+            return ret;
+        }
+        if (ret != AVERROR(EAGAIN)) {
+            ++attempt_count;
+            continue;
+        }
+
+        // 需要更多输入
+        ret = readPacket(packet);
+
+        // 解复用流水线被中止
+        if (ret == AVERROR_EXIT) {
+            return ret;
+        }
+
+        // 文件末尾，执行 flush，之后 receive 依次取出剩余帧直至 AVERROR_EOF
+        if (ret == AVERROR_EOF) {
+            avcodec_send_packet(video_codec_ctx, nullptr);
+            continue;
+        }
+
+        // 其他错误跳过
+        if (ret < 0) {
+            ++attempt_count;
+            continue;
+        }
+        attempt_count = 0;
+
+        // 跳过非视频流
+        if (packet->stream_index != video_stream_idx) {
+            av_packet_unref(packet);
+            continue;
+        }
+
+        // 目标帧之前的帧解码后也会丢弃，在解码器支持时跳过其中的非参考帧；
+        // 随机读取且开启帧缓存时保留这些中间帧以便来回拖动
+        // 呈现落后时同样跳过非参考帧，精确 seek 途中不跳过以免丢失目标帧
+        if (video_codec_ctx->skip_frame <= AVDISCARD_NONREF) {
+            const bool unwanted = target_pts != AV_NOPTS_VALUE && packet->pts != AV_NOPTS_VALUE && packet->pts < target_pts;
+            const bool skip = (unwanted && !(caching && frame_cache.isEnabled())) || (catching_up && target_pts == AV_NOPTS_VALUE);
+            video_codec_ctx->skip_frame = skip ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+        }
+
+        // 发送 packet
+        ret = avcodec_send_packet(video_codec_ctx, packet);
+        av_packet_unref(packet);
+        if (ret < 0) {
+            ++attempt_count;
+        }
+    }
+
+    return ret;
+}
+
+// 呈现时钟的倍速：帧步长为 n 时每帧前进 n 帧，关键帧模式下为 trick_speed，负数为倒放
+double QmVideoDecoderPrivate::playbackRate() const
+{
+    const qint64 step = frame_step;
+    const int speed = trick_speed;
+    if (speed > 1) {
+        return step < 0 ? -speed : speed;
+    }
+    return static_cast<double>(step);
+}
+
+// 已有索引时取离目标最近的关键帧；不为缩略图建立索引，扫描整个文件远比提取缩略图耗时
+QList<QImage> QmVideoDecoderPrivate::thumbnails(const QList<qint64>& frame_numbers, const QSize& size)
+{
+    QList<qint64> pts_list;
+    pts_list.reserve(frame_numbers.size());
+    std::unique_lock lock(decode_mutex);
+    for (qint64 frame_no : frame_numbers) {
+        if (index.isValid()) {
+            frame_no = std::clamp<qint64>(frame_no, 0, index.frameCount() - 1);
+            qint64 keyframe = std::max<qint64>(index.keyframeBefore(frame_no), 0);
+            const qint64 next_keyframe = index.keyframeAfter(frame_no);
+            if (next_keyframe >= 0 && next_keyframe - frame_no < frame_no - keyframe) {
+                keyframe = next_keyframe;
+            }
+            pts_list.append(index.ptsOfFrame(keyframe));
+        } else {
+            pts_list.append(start_pts + av_rescale_q(std::llround(frame_no * AV_TIME_BASE / fps), AVRational { 1, AV_TIME_BASE }, time_base));
+        }
+    }
+    lock.unlock();
+    const QSize thumbnail_size = video_size.scaled(size, Qt::KeepAspectRatio);
+    return QmThumbnailer::extract(video_path, video_stream_idx, pts_list, thumbnail_size);
+}
+
+void QmVideoDecoderPrivate::demuxLoop(std::stop_token st)
+{
+    int attempt_count = 0;
+    while (!st.stop_requested()) {
+        AVPacket* pkt = av_packet_alloc();
+        quint64 generation = 0;
+        int ret = 0;
+        {
+            std::scoped_lock lock(demux_mutex);
+            generation = packet_queue.generation();
+            ret = av_read_frame(fmt_ctx, pkt);
+        }
+        if (ret < 0) {
+            av_packet_free(&pkt);
+            // 文件末尾或连续读取失败，等待 seek（如循环播放）后继续
+            if (ret == AVERROR_EOF || ++attempt_count >= 50) {
+                attempt_count = 0;
+                packet_queue.finish(generation);
+                if (!packet_queue.waitForClear(generation, st)) {
+                    break;
+                }
+            }
+            continue;
+        }
+        attempt_count = 0;
+
+        // 跳过非视频流
+        if (pkt->stream_index != video_stream_idx) {
+            av_packet_free(&pkt);
+            continue;
+        }
+        if (!packet_queue.push(pkt, generation, st)) {
+            break;
+        }
+    }
+}
+
+QmMemoryBudget::Usage QmVideoDecoderPrivate::memoryUsage() const
+{
+    QmMemoryBudget::Usage usage;
+    usage.bytes[QmMemoryBudget::CodecBuffers] = codec_bytes;
+    usage.bytes[QmMemoryBudget::FramePool] = frame_pool.stats().bytes;
+    usage.bytes[QmMemoryBudget::FrameCache] = frame_cache.stats().bytes;
+    // 深度缩小后超出的帧在呈现后即释放，按缩小后的深度计
+    const int level = frame_queue.level();
+    const int depth = frame_queue.depth();
+    const qint64 queued = frame_queue.bytes();
+    usage.bytes[QmMemoryBudget::LookaheadQueue] = (level > depth ? queued * depth / level : queued) + reverse_bytes;
+    usage.bytes[QmMemoryBudget::PacketQueue] = packet_queue.bytes();
+    return usage;
+}
+
+// 按重建代价从低到高回收：缓存的帧可以重新解码，空闲缓冲区可以重新分配，最后才减少预读。
+// 由 QmMemoryBudget 在任意上报线程中调用，只能使用各组件自身的锁，不能持有 decode_mutex
+QmMemoryBudget::Usage QmVideoDecoderPrivate::reclaimMemory(qint64 bytes)
+{
+    bytes -= frame_cache.shrink(frame_cache.stats().bytes - bytes);
+    if (bytes > 0) {
+        bytes -= frame_pool.trim();
+    }
+    const int depth = frame_queue.depth();
+    if (bytes > 0 && depth > 1) {
+        frame_queue.setDepth(depth / 2);
+        lookahead_reduced = true;
+    }
+    return memoryUsage();
+}
+
+void QmVideoDecoderPrivate::reportMemory()
+{
+    if (memory_client < 0) {
+        return;
+    }
+    QmMemoryBudget* budget = QmMemoryBudget::instance();
+    // 余量不少于恢复所需的两倍时恢复预读深度，避免在预算边缘反复缩放
+    if (lookahead_reduced) {
+        const int level = frame_queue.level();
+        const qint64 frame_bytes = level > 0 ? frame_queue.bytes() / level : 0;
+        if (budget->headroom() / 2 >= frame_bytes * (lookahead_depth - frame_queue.depth())) {
+            lookahead_reduced = false;
+            frame_queue.setDepth(lookahead_depth);
+            frame_queue.setWatermarks(lookahead_low, lookahead_high);
+        }
+    }
+    budget->report(memory_client, memoryUsage());
+}
+
 QmVideoDecoder::QmVideoDecoder()
     : d_(new QmVideoDecoderPrivate)
 {
     d_->thread = new QThread();
+    d_->delivery.setBytePool(&d_->frame_pool);
 
     moveToThread(d_->thread);
     connect(d_->thread, &QThread::started, this, [this] {
@@ -125,13 +882,24 @@ bool QmVideoDecoder::open(const QString& video_path)
         }
     }
     d_->fps = av_q2d(frame_rate);
+    d_->time_base = video_stream->time_base;
+    d_->start_pts = video_stream->start_time == AV_NOPTS_VALUE ? 0 : video_stream->start_time;
     d_->duration = (static_cast<double>(d_->fmt_ctx->duration) / AV_TIME_BASE) * 1000.0;
     d_->frame_count = std::llround(d_->duration * d_->fps / 1000.0);
     d_->video_size = { video_stream->codecpar->width, video_stream->codecpar->height };
     d_->video_path = video_path;
+    // 有索引缓存时使用准确的帧数，替代按时长与帧率的估算
+    d_->loadIndex();
 
     d_->video_codec_ctx = avcodec_alloc_context3(video_codec);
     avcodec_parameters_to_context(d_->video_codec_ctx, video_stream->codecpar);
+    // 多线程参数必须在 avcodec_open2 之前设置，使用调度器时并行来自多路之间，每路只用单线程
+    if (d_->threading_mode == NoThreading || d_->scheduler) {
+        d_->video_codec_ctx->thread_count = 1;
+    } else {
+        d_->video_codec_ctx->thread_count = resolveThreadCount(d_->thread_count);
+    }
+    d_->video_codec_ctx->thread_type = toThreadType(d_->threading_mode);
     if (avcodec_open2(d_->video_codec_ctx, video_codec, nullptr) < 0) {
         qDebug() << "Failed to open codec!";
         return false;
@@ -139,15 +907,25 @@ bool QmVideoDecoder::open(const QString& video_path)
     d_->packet = av_packet_alloc();
     d_->frame = av_frame_alloc();
 
-    if (d_->format == Image && !d_->sws_ctx) {
-        // 初始化转换器
-        d_->sws_ctx = sws_getContext(d_->video_size.width(), d_->video_size.height(), d_->video_codec_ctx->pix_fmt, d_->video_size.width(), d_->video_size.height(), AV_PIX_FMT_RGB24,
-            SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
-        d_->rgb_frame = av_frame_alloc();
-        int rgb_buffer_size = av_image_get_buffer_size(AV_PIX_FMT_RGB24, d_->video_size.width(), d_->video_size.height(), 1);
-        d_->rgb_buffer = (uint8_t*)av_malloc(rgb_buffer_size);
-        av_image_fill_arrays(d_->rgb_frame->data, d_->rgb_frame->linesize, d_->rgb_buffer, AV_PIX_FMT_RGB24, d_->video_size.width(), d_->video_size.height(), 1);
+    if (d_->index_mode == IndexOnOpen) {
+        d_->ensureIndex();
+    }
+
+    // 初始化转换器
+    d_->updateConverter();
+
+    if (d_->scheduler) {
+        d_->stream_scheduler = d_->scheduler;
+        d_->stream_id = d_->scheduler->registerStream(video_path);
     }
+    // 解码器内部缓冲按参考帧、每个帧级线程与一帧输出各占一帧估算
+    const int codec_format = video_stream->codecpar->format >= 0 ? video_stream->codecpar->format : AV_PIX_FMT_YUV420P;
+    const int codec_frame_bytes = av_image_get_buffer_size(static_cast<AVPixelFormat>(codec_format), d_->video_size.width(), d_->video_size.height(), 1);
+    d_->codec_bytes = static_cast<qint64>(std::max(codec_frame_bytes, 0)) * (std::max(d_->video_codec_ctx->refs, 1) + d_->video_codec_ctx->thread_count + 1);
+    d_->memory_client = QmMemoryBudget::instance()->registerClient(video_path, d_->memory_priority, [this](qint64 bytes) {
+        return d_->reclaimMemory(bytes);
+    });
+    d_->reportMemory();
 
     d_->state = Waiting;
 
@@ -163,16 +941,23 @@ void QmVideoDecoder::close()
         d_->thread->quit();
         d_->thread->wait();
     }
-    if (d_->frame) {
-        av_frame_free(&d_->frame);
+    if (d_->index_thread.joinable()) {
+        d_->index_thread.request_stop();
+        d_->index_thread.join();
     }
-    if (d_->rgb_frame) {
-        av_frame_free(&d_->rgb_frame);
+    if (d_->stream_scheduler) {
+        d_->stream_scheduler->unregisterStream(d_->stream_id);
+        d_->stream_scheduler = nullptr;
+        d_->stream_id = -1;
     }
-    if (d_->rgb_buffer) {
-        av_free(d_->rgb_buffer);
-        d_->rgb_buffer = nullptr;
+    if (d_->memory_client >= 0) {
+        QmMemoryBudget::instance()->unregisterClient(d_->memory_client);
+        d_->memory_client = -1;
+    }
+    if (d_->frame) {
+        av_frame_free(&d_->frame);
     }
+    d_->frame_pool.release();
     if (d_->packet) {
         av_packet_free(&d_->packet);
     }
@@ -180,45 +965,288 @@ void QmVideoDecoder::close()
         sws_freeContext(d_->sws_ctx);
         d_->sws_ctx = nullptr;
     }
+    if (d_->yuv_sws_ctx) {
+        sws_freeContext(d_->yuv_sws_ctx);
+        d_->yuv_sws_ctx = nullptr;
+    }
     if (d_->video_codec_ctx) {
         avcodec_free_context(&d_->video_codec_ctx);
     }
     if (d_->fmt_ctx) {
         avformat_close_input(&d_->fmt_ctx);
     }
+    d_->frame_cache.clear();
+    d_->index.clear();
+    d_->index_attempted = false;
+    d_->last_frame_no = -1;
+    d_->target_pts = AV_NOPTS_VALUE;
     d_->video_stream_idx = -1;
     d_->video_path = "";
     d_->frame_count = 0;
     d_->duration = 0;
     d_->fps = 1.0;
+    d_->codec_bytes = 0;
     d_->state = Idle;
 }
 
-void QmVideoDecoder::setFrameStep(qint64 frame_step)
+void QmVideoDecoder::setFrameStep(qint64 frame_step)
+{
+    if (frame_step == 0) {
+        frame_step = 1;
+    }
+    d_->frame_step = frame_step;
+}
+
+void QmVideoDecoder::setLoop(bool loop)
+{
+    d_->loop.store(loop, std::memory_order_relaxed);
+}
+
+void QmVideoDecoder::setTrickPlaySpeed(int speed)
+{
+    d_->trick_speed = std::max(speed, 1);
+}
+
+int QmVideoDecoder::trickPlaySpeed() const
+{
+    return d_->trick_speed;
+}
+
+void QmVideoDecoder::setExternalClock(QmVideoClock* clock)
+{
+    d_->external_clock = clock;
+}
+
+QmVideoClock* QmVideoDecoder::clock() const
+{
+    QmVideoClock* clock = d_->external_clock;
+    return clock ? clock : &d_->internal_clock;
+}
+
+QmVideoDecoder::PresentStats QmVideoDecoder::presentStats() const
+{
+    return { d_->presented_count, d_->late_count, d_->dropped_count, d_->backpressure_dropped };
+}
+
+void QmVideoDecoder::setDeliveryPolicy(DeliveryPolicy policy, int max_in_flight)
+{
+    d_->delivery.setLimit(max_in_flight);
+    d_->delivery_policy = policy;
+}
+
+QmVideoDecoder::DeliveryPolicy QmVideoDecoder::deliveryPolicy() const
+{
+    return d_->delivery_policy;
+}
+
+int QmVideoDecoder::maxInFlightFrames() const
+{
+    return d_->delivery.limit();
+}
+
+int QmVideoDecoder::inFlightFrames() const
+{
+    return d_->delivery.inFlight();
+}
+
+void QmVideoDecoder::setRealtime(bool realtime)
+{
+    d_->realtime = realtime;
+}
+
+bool QmVideoDecoder::isRealtime() const
+{
+    return d_->realtime;
+}
+
+void QmVideoDecoder::setPullMode(bool enabled, int capacity)
+{
+    if (d_->state == Playing || d_->state == Paused) {
+        qDebug() << "QmVideoDecoder::setPullMode. must be called before play";
+        return;
+    }
+    if (enabled && !isFrameFormat(d_->format)) {
+        qDebug() << "QmVideoDecoder::setPullMode. output format" << d_->format << "does not produce QmVideoFrame";
+        return;
+    }
+    d_->frame_ring = enabled ? std::make_unique<QmFrameRing>(capacity) : nullptr;
+}
+
+bool QmVideoDecoder::isPullMode() const
+{
+    return d_->frame_ring != nullptr;
+}
+
+bool QmVideoDecoder::pullFrame(QmVideoFrame* frame, int timeout_ms)
+{
+    QmFrameRing* ring = d_->frame_ring.get();
+    if (!ring) {
+        return false;
+    }
+    if (timeout_ms <= 0) {
+        return ring->pop(frame);
+    }
+    return ring->waitPop(frame, std::chrono::milliseconds(timeout_ms));
+}
+
+void QmVideoDecoder::setReverseGopBufferCount(int count)
+{
+    d_->reverse_gop_count = std::max(count, 1);
+}
+
+int QmVideoDecoder::reverseGopBufferCount() const
+{
+    return d_->reverse_gop_count;
+}
+
+void QmVideoDecoder::setOutputFormat(Format format, const QSize& size, const QRect& roi, ScaleAlgorithm algorithm)
+{
+    std::scoped_lock lock(d_->decode_mutex);
+    {
+        std::scoped_lock convert_lock(d_->convert_mutex);
+        d_->format = format;
+        d_->output_size = size;
+        d_->output_roi = roi;
+        d_->sws_flags = toSwsFlags(algorithm);
+    }
+    // 初始化转换器
+    d_->updateConverter();
+}
+
+void QmVideoDecoder::setIndexMode(IndexMode mode)
+{
+    d_->index_mode = mode;
+}
+
+void QmVideoDecoder::setIndexCacheDir(const QString& cache_dir)
+{
+    d_->index_cache_dir = cache_dir;
+}
+
+void QmVideoDecoder::setThreading(ThreadingMode mode, int thread_count)
+{
+    d_->threading_mode = mode;
+    d_->thread_count = thread_count;
+}
+
+void QmVideoDecoder::setScheduler(QmDecoderScheduler* scheduler)
+{
+    d_->scheduler = scheduler;
+}
+
+QmDecoderScheduler* QmVideoDecoder::scheduler() const
+{
+    return d_->scheduler;
+}
+
+int QmVideoDecoder::schedulerStream() const
+{
+    return d_->stream_id;
+}
+
+void QmVideoDecoder::setMemoryPriority(int priority)
+{
+    d_->memory_priority = priority;
+    if (d_->memory_client >= 0) {
+        QmMemoryBudget::instance()->setPriority(d_->memory_client, priority);
+    }
+}
+
+int QmVideoDecoder::memoryPriority() const
+{
+    return d_->memory_priority;
+}
+
+qint64 QmVideoDecoder::memoryUsage() const
+{
+    return d_->memoryUsage().total();
+}
+
+int QmVideoDecoder::memoryClient() const
+{
+    return d_->memory_client;
+}
+
+QmVideoDecoder::ThreadingMode QmVideoDecoder::threadingMode() const
+{
+    if (!d_->video_codec_ctx) {
+        return d_->scheduler ? NoThreading : d_->threading_mode;
+    }
+    // active_thread_type 为解码器实际启用的模式，不支持的模式会被静默忽略
+    switch (d_->video_codec_ctx->active_thread_type) {
+    case FF_THREAD_FRAME:
+        return FrameThreading;
+    case FF_THREAD_SLICE:
+        return SliceThreading;
+    default:
+        return NoThreading;
+    }
+}
+
+int QmVideoDecoder::threadCount() const
+{
+    if (!d_->video_codec_ctx) {
+        return d_->threading_mode == NoThreading || d_->scheduler ? 1 : resolveThreadCount(d_->thread_count);
+    }
+    return d_->video_codec_ctx->active_thread_type == 0 ? 1 : d_->video_codec_ctx->thread_count;
+}
+
+void QmVideoDecoder::setLookaheadDepth(int depth)
+{
+    d_->frame_queue.setDepth(depth);
+    d_->lookahead_depth = d_->frame_queue.depth();
+    d_->lookahead_low = d_->frame_queue.lowWatermark();
+    d_->lookahead_high = d_->frame_queue.highWatermark();
+    d_->lookahead_reduced = false;
+}
+
+void QmVideoDecoder::setLookaheadWatermarks(int low, int high)
+{
+    d_->frame_queue.setWatermarks(low, high);
+    d_->lookahead_low = d_->frame_queue.lowWatermark();
+    d_->lookahead_high = d_->frame_queue.highWatermark();
+}
+
+int QmVideoDecoder::lookaheadDepth() const
 {
-    if (frame_step == 0) {
-        frame_step = 1;
-    }
-    d_->frame_step = frame_step;
+    return d_->frame_queue.depth();
 }
 
-void QmVideoDecoder::setLoop(bool loop)
+QmVideoDecoder::PoolStats QmVideoDecoder::poolStats() const
 {
-    d_->loop.store(loop, std::memory_order_relaxed);
+    const QmFramePool::Stats stats = d_->frame_pool.stats();
+    return { stats.hits, stats.misses, stats.bytes, stats.peak_bytes };
 }
 
-void QmVideoDecoder::setOutputFormat(Format format)
+QmVideoDecoder::CacheStats QmVideoDecoder::frameCacheStats() const
 {
-    d_->format = format;
-    if (d_->state == Waiting && format == Image && !d_->sws_ctx) {
-        // 初始化转换器
-        d_->sws_ctx = sws_getContext(d_->video_size.width(), d_->video_size.height(), d_->video_codec_ctx->pix_fmt, d_->video_size.width(), d_->video_size.height(), AV_PIX_FMT_RGB24,
-            SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
-        d_->rgb_frame = av_frame_alloc();
-        int rgb_buffer_size = av_image_get_buffer_size(AV_PIX_FMT_RGB24, d_->video_size.width(), d_->video_size.height(), 1);
-        d_->rgb_buffer = (uint8_t*)av_malloc(rgb_buffer_size);
-        av_image_fill_arrays(d_->rgb_frame->data, d_->rgb_frame->linesize, d_->rgb_buffer, AV_PIX_FMT_RGB24, d_->video_size.width(), d_->video_size.height(), 1);
-    }
+    const QmFrameCache::Stats stats = d_->frame_cache.stats();
+    return { stats.hits, stats.misses, stats.bytes, stats.budget, stats.frames };
+}
+
+void QmVideoDecoder::setFrameCacheBudget(qint64 bytes)
+{
+    d_->frame_cache.setBudget(bytes);
+}
+
+int QmVideoDecoder::lookaheadLevel() const
+{
+    return d_->frame_queue.level();
+}
+
+void QmVideoDecoder::setPacketQueueLimits(int max_packets, qint64 max_bytes)
+{
+    d_->packet_queue.setLimits(max_packets, max_bytes);
+}
+
+int QmVideoDecoder::packetQueueCount() const
+{
+    return d_->packet_queue.count();
+}
+
+qint64 QmVideoDecoder::packetQueueBytes() const
+{
+    return d_->packet_queue.bytes();
 }
 
 void QmVideoDecoder::play()
@@ -229,6 +1257,10 @@ void QmVideoDecoder::play()
     if (d_->state == Playing) {
         stop();
     }
+    // setPullMode 之后仍可能通过 setOutputFormat 改为其他格式，这些帧无法放入环形缓冲区
+    if (d_->frame_ring && !isFrameFormat(d_->format)) {
+        qDebug() << "QmVideoDecoder::play. pull mode requires Frame, Yuv420pPlanar or Nv12 output, frames will be dropped";
+    }
     d_->state = Playing;
     if (!d_->thread->isRunning()) {
         d_->stop_source = std::stop_source();
@@ -273,100 +1305,157 @@ void QmVideoDecoder::stop()
 
 void QmVideoDecoder::seekToFrame(qint64 frame_no)
 {
+    std::scoped_lock lock(d_->decode_mutex);
     if (seekToFrameImpl(frame_no)) {
         d_->frame_index = frame_no;
+        d_->frame_queue.clear();
     }
 }
 
-QVariant QmVideoDecoder::nextFrame()
-{
-    auto processFrame = [this]() -> QVariant {
-        // switch (d_->frame->pict_type) {
-        // case AV_PICTURE_TYPE_I:
-        //     qDebug() << "=> I:" << d_->frame->pts;
-        //     break;
-        // case AV_PICTURE_TYPE_P:
-        //     qDebug() << "   P:" << d_->frame->pts;
-        //     break;
-        // case AV_PICTURE_TYPE_B:
-        //     qDebug() << "   B:" << d_->frame->pts;
-        //     break;
-        // default:
-        //     break;
-        // }
-
-        if (d_->format == Yuv420p) {
-            return decodeToYuv(d_->frame,
-                d_->video_size.width(),
-                d_->video_size.height());
-        } else {
-            return decodeToImage(d_->sws_ctx,
-                d_->frame,
-                d_->rgb_frame,
-                d_->rgb_buffer,
-                d_->video_size.width(),
-                d_->video_size.height());
-        }
-    };
-    int ret = 0;
-    int attempt_count = 0;
-
-    while (attempt_count < 50) {
-        ret = av_read_frame(d_->fmt_ctx, d_->packet);
+QVariant QmVideoDecoder::nextFrame(int* error)
+{
+    qint64 frame_no = -1;
+    const int ret = d_->decodeNext(&frame_no);
+    if (error) {
+        *error = ret;
+    }
+    if (ret < 0) {
+        return {};
+    }
+    return d_->convertFrame(d_->frame, frame_no);
+}
 
-        // 文件末尾，执行 flush
-        if (ret == AVERROR_EOF) {
-            avcodec_send_packet(d_->video_codec_ctx, nullptr);
-            while ((ret = avcodec_receive_frame(d_->video_codec_ctx, d_->frame)) >= 0) {
-                return processFrame();
-            }
-            return {};
+QVariant QmVideoDecoder::readFrame(qint64 frame_no)
+{
+    auto report_guard = qScopeGuard([this] {
+        d_->reportMemory();
+    });
+    if (d_->frame_cache.isEnabled()) {
+        std::scoped_lock lock(d_->decode_mutex);
+        QmVideoFrame cached = d_->frame_cache.find(frame_no);
+        if (!cached.isNull()) {
+            return d_->convertFrame(cached.avFrame(), frame_no);
         }
+    }
+    seekToFrame(frame_no);
+    std::scoped_lock lock(d_->decode_mutex);
+    d_->caching = true;
+    auto caching_guard = qScopeGuard([this] {
+        d_->caching = false;
+    });
+    return nextFrame();
+}
 
-        // 其他错误跳过
-        if (ret < 0) {
-            ++attempt_count;
-            continue;
+QList<QVariant> QmVideoDecoder::readFrames(const QList<qint64>& frame_numbers)
+{
+    QList<QVariant> frames(frame_numbers.size());
+    // 同一帧号可能出现多次
+    std::unordered_multimap<qint64, qsizetype> positions;
+    positions.reserve(frame_numbers.size());
+    for (qsizetype i = 0; i < frame_numbers.size(); ++i) {
+        positions.emplace(frame_numbers[i], i);
+    }
+    readFrames(frame_numbers, [&frames, &positions](qint64 frame_no, const QVariant& frame) {
+        auto [first, last] = positions.equal_range(frame_no);
+        for (auto it = first; it != last; ++it) {
+            frames[it->second] = frame;
         }
-        attempt_count = 0;
+    });
+    return frames;
+}
 
-        // 跳过非视频流
-        if (d_->packet->stream_index != d_->video_stream_idx) {
-            av_packet_unref(d_->packet);
-            continue;
-        }
+void QmVideoDecoder::readFrames(const QList<qint64>& frame_numbers, const FrameCallback& callback)
+{
+    if (d_->state == Idle) {
+        return;
+    }
+    std::vector<qint64> targets(frame_numbers.begin(), frame_numbers.end());
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
 
-        // 发送 packet
-        ret = avcodec_send_packet(d_->video_codec_ctx, d_->packet);
-        av_packet_unref(d_->packet);
-        if (ret < 0) {
-            ++attempt_count;
-            continue;
+    // 按帧号升序解码：同一 GOP 内的目标由 seekToFrameImpl 判断为向前解码，每个 GOP 只 seek 一次
+    for (qint64 frame_no : targets) {
+        QVariant frame;
+        {
+            std::scoped_lock lock(d_->decode_mutex);
+            // 越界的帧号按失败处理，否则 seekToFrameImpl 会截断到最后一帧并以请求的帧号返回
+            if (frame_no >= 0 && (d_->frame_count <= 0 || frame_no < d_->frame_count)) {
+                if (d_->frame_cache.isEnabled()) {
+                    QmVideoFrame cached = d_->frame_cache.find(frame_no);
+                    if (!cached.isNull()) {
+                        frame = d_->convertFrame(cached.avFrame(), frame_no);
+                    }
+                }
+                if (!frame.isValid() && seekToFrameImpl(frame_no)) {
+                    d_->caching = true;
+                    frame = nextFrame();
+                    d_->caching = false;
+                }
+                d_->frame_index = frame_no;
+            }
         }
+        d_->reportMemory();
+        callback(frame_no, frame);
+    }
+    d_->frame_queue.clear();
+}
 
-        // 接收帧
-        while ((ret = avcodec_receive_frame(d_->video_codec_ctx, d_->frame)) >= 0) {
-            return processFrame();
-        }
+QList<QImage> QmVideoDecoder::readThumbnails(int count, const QSize& size)
+{
+    if (d_->state == Idle || count <= 0 || d_->frame_count <= 0) {
+        return {};
+    }
+    // 取每一段的中间帧，避开片头片尾的黑场
+    QList<qint64> frame_numbers;
+    frame_numbers.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        frame_numbers.append((2 * i + 1) * d_->frame_count / (2 * count));
+    }
+    return d_->thumbnails(frame_numbers, size);
+}
 
-        // 需要更多输入
-        if (ret == AVERROR(EAGAIN)) {
-            continue;
-        }
-        // 解码结束
-        else if (ret == AVERROR_EOF) {
-            return {};
-        } else {
-            ++attempt_count;
-        }
+QList<QImage> QmVideoDecoder::readThumbnailsByInterval(qint64 interval_ms, const QSize& size)
+{
+    if (d_->state == Idle || interval_ms <= 0) {
+        return {};
+    }
+    QList<qint64> frame_numbers;
+    for (qint64 time_ms = 0; time_ms < d_->duration; time_ms += interval_ms) {
+        frame_numbers.append(std::llround(time_ms * d_->fps / 1000));
     }
+    return d_->thumbnails(frame_numbers, size);
+}
 
-    return {};
+QVariant QmVideoDecoder::readKeyframe(qint64 frame_no)
+{
+    if (d_->state == Idle) {
+        return {};
+    }
+    auto report_guard = qScopeGuard([this] {
+        d_->reportMemory();
+    });
+    std::scoped_lock lock(d_->decode_mutex);
+    qint64 keyframe = -1;
+    QVariant data = decodeKeyframe(frame_no, true, &keyframe);
+    if (keyframe >= 0) {
+        // 非关键帧已被丢弃，重新定位使 readNextFrame 从关键帧的下一帧继续
+        if (seekToFrameImpl(keyframe + 1)) {
+            d_->frame_index = keyframe + 1;
+            d_->frame_queue.clear();
+        }
+    }
+    return data;
 }
 
-QVariant QmVideoDecoder::readFrame(qint64 frame_no)
+QVariant QmVideoDecoder::readNextFrame()
 {
-    seekToFrame(frame_no);
+    if (d_->state == Idle) {
+        return {};
+    }
+    auto report_guard = qScopeGuard([this] {
+        d_->reportMemory();
+    });
+    std::scoped_lock lock(d_->decode_mutex);
     return nextFrame();
 }
 
@@ -375,11 +1464,44 @@ bool QmVideoDecoder::seekToFrameImpl(qint64 frame_no)
     if (d_->state == Idle) {
         return false;
     }
-    int64_t timestamp = static_cast<double>(frame_no) / d_->fps * AV_TIME_BASE;
-    if (av_seek_frame(d_->fmt_ctx, -1, timestamp, AVSEEK_FLAG_BACKWARD) < 0) {
-        return false;
+    // 回到开头（stop、循环播放）不需要索引
+    if (frame_no > 0) {
+        d_->ensureIndex();
+    }
+
+    // 向前解码需要经过的帧数，目标不在当前解码位置之后时为 -1
+    const qint64 forward_frames = (d_->last_frame_no >= 0 && d_->last_frame_no < frame_no) ? frame_no - d_->last_frame_no : -1;
+    int64_t seek_pts = d_->start_pts;
+    if (frame_no <= 0) {
+        d_->target_pts = AV_NOPTS_VALUE;
+    } else if (d_->index.isValid()) {
+        frame_no = std::min(frame_no, d_->index.frameCount() - 1);
+        const qint64 keyframe = std::max<qint64>(d_->index.keyframeBefore(frame_no), 0);
+        d_->target_pts = d_->index.ptsOfFrame(frame_no);
+        // 向前解码比从目标所在 GOP 的关键帧解码更省时不 seek；目标与当前位置在同一 GOP 内时总是如此
+        if (forward_frames >= 0 && forward_frames <= frame_no - keyframe + kSeekCostFrames) {
+            return true;
+        }
+        seek_pts = d_->index.ptsOfFrame(keyframe);
+    } else {
+        // 没有索引时按帧率估算目标 pts，容忍半帧误差
+        const AVRational us_time_base { 1, AV_TIME_BASE };
+        seek_pts += av_rescale_q(std::llround(frame_no * AV_TIME_BASE / d_->fps), us_time_base, d_->time_base);
+        d_->target_pts = seek_pts - av_rescale_q(std::llround(AV_TIME_BASE / d_->fps / 2), us_time_base, d_->time_base);
+        if (forward_frames >= 0 && forward_frames <= kMaxForwardFrames) {
+            return true;
+        }
+    }
+    {
+        std::scoped_lock lock(d_->demux_mutex);
+        if (av_seek_frame(d_->fmt_ctx, d_->video_stream_idx, seek_pts, AVSEEK_FLAG_BACKWARD) < 0) {
+            return false;
+        }
+        // 丢弃 seek 之前已读出的 packet
+        d_->packet_queue.clear();
     }
     avcodec_flush_buffers(d_->video_codec_ctx);
+    d_->last_frame_no = -1;
     return true;
 }
 
@@ -403,6 +1525,32 @@ QSize QmVideoDecoder::size() const
     return d_->video_size;
 }
 
+QSize QmVideoDecoder::outputSize() const
+{
+    std::scoped_lock lock(d_->convert_mutex);
+    return d_->outputSize(d_->cropRect(d_->video_size).size());
+}
+
+QString QmVideoDecoder::path() const
+{
+    return d_->video_path;
+}
+
+QmVideoDecoder::State QmVideoDecoder::state() const
+{
+    return d_->state;
+}
+
+double QmVideoDecoder::fps() const
+{
+    return d_->fps;
+}
+
+qint64 QmVideoDecoder::frameCount() const
+{
+    return d_->frame_count;
+}
+
 QVariant QmVideoDecoder::decodeFrame(qint64 frame_no, int* error)
 {
     std::unique_ptr<int> ffmpeg_ret_guard(new int);
@@ -415,13 +1563,303 @@ QVariant QmVideoDecoder::decodeFrame(qint64 frame_no, int* error)
     if (d_->state == Idle) {
         return {};
     }
+    // 小步长时 seekToFrameImpl 不会真正 seek，而是继续向前解码并丢弃中间帧
     if (d_->frame_step != 1) {
         if (!seekToFrameImpl(frame_no)) {
             return {};
         }
     }
 
-    return nextFrame();
+    return nextFrame(ret);
+}
+
+// 只解码一个关键帧：backward 为 true 时取 frame_no 及之前最近的关键帧，否则取之后最近的关键帧
+QVariant QmVideoDecoder::decodeKeyframe(qint64 frame_no, bool backward, qint64* keyframe, int* error)
+{
+    int ret = 0;
+    *keyframe = -1;
+    const bool has_index = d_->index.isValid();
+    if (has_index) {
+        const qint64 target = backward ? d_->index.keyframeBefore(frame_no) : d_->index.keyframeAfter(frame_no - 1);
+        if (target < 0) {
+            ret = AVERROR_EOF;
+        } else if (!seekToFrameImpl(target)) {
+            ret = AVERROR(EINVAL);
+        }
+    } else if (backward) {
+        // 必须真正 seek：从当前位置向前解码得到的是当前位置之后的关键帧，可能晚于目标
+        d_->last_frame_no = -1;
+        if (!seekToFrameImpl(frame_no)) {
+            ret = AVERROR(EINVAL);
+        }
+        // seek 已落在目标之前的关键帧上，保留该帧
+        d_->target_pts = AV_NOPTS_VALUE;
+    }
+
+    if (ret >= 0) {
+        // 没有索引时向前顺序读取，解码器只解码关键帧，其余 packet 直接丢弃
+        d_->video_codec_ctx->skip_frame = AVDISCARD_NONKEY;
+        qint64 decoded_no = -1;
+        do {
+            ret = d_->decodeNext(&decoded_no);
+        } while (ret >= 0 && !has_index && !backward && decoded_no < frame_no);
+        d_->video_codec_ctx->skip_frame = AVDISCARD_DEFAULT;
+        // 跳过了非关键帧，之后的 seek 不能从当前位置继续解码
+        d_->last_frame_no = -1;
+        if (ret >= 0) {
+            *keyframe = decoded_no;
+        }
+    }
+    if (error) {
+        *error = ret;
+    }
+    if (ret < 0) {
+        return {};
+    }
+    return d_->convertFrame(d_->frame, *keyframe);
+}
+
+void QmVideoDecoder::decodeLoop(std::stop_token st)
+{
+    bool trick_play = false;
+    while (!st.stop_requested()) {
+        if (d_->frame_step < 0 && d_->trick_speed <= 1) {
+            bool has_index = false;
+            {
+                std::scoped_lock lock(d_->decode_mutex);
+                d_->ensureIndex();
+                has_index = d_->index.isValid();
+            }
+            // 没有索引时退回逐帧 seek
+            if (has_index) {
+                if (reverseDecodeLoop(st)) {
+                    break;
+                }
+                continue;
+            }
+        }
+        if (!decodeStep(st, &trick_play)) {
+            break;
+        }
+    }
+}
+
+// 顺序或关键帧模式解码一帧放入预读队列，返回 false 表示播放结束或被停止
+bool QmVideoDecoder::decodeStep(std::stop_token st, bool* trick_play)
+{
+    QmQueuedFrame queued;
+    quint64 generation = 0;
+    bool finished = false;
+    {
+        std::scoped_lock lock(d_->decode_mutex);
+        generation = d_->frame_queue.generation();
+        int ret = 0;
+        const qint64 trick_speed = d_->trick_speed;
+        if (trick_speed > 1) {
+            // 按倍速跳到下一个关键帧
+            const bool backward = d_->frame_step < 0;
+            queued.data = decodeKeyframe(d_->frame_index, backward, &queued.frame_no, &ret);
+            if (ret >= 0) {
+                queued.timestamp = d_->frameTimestamp(d_->frame);
+                d_->frame_index = queued.frame_no + (backward ? -trick_speed : trick_speed);
+            }
+        } else {
+            // 退出关键帧模式后解码器缺少参考帧，需要重新定位
+            if (*trick_play && !seekToFrameImpl(d_->frame_index)) {
+                ret = AVERROR(EINVAL);
+            }
+            queued.frame_no = d_->frame_index;
+            queued.data = decodeFrame(d_->frame_index, &ret);
+            if (ret >= 0) {
+                queued.timestamp = d_->frameTimestamp(d_->frame);
+            }
+            d_->frame_index += d_->frame_step;
+        }
+        *trick_play = trick_speed > 1;
+        if ((d_->frame_index > d_->frame_count || d_->frame_index < 0) || ret == AVERROR_EOF) {
+            if (d_->loop) {
+                d_->frame_index = (d_->frame_step < 0) ? d_->frame_count : 0;
+                std::ignore = seekToFrameImpl(d_->frame_index);
+            } else {
+                finished = true;
+            }
+        }
+    }
+    queued.bytes = byteSizeOf(queued.data);
+    if (queued.data.isValid() && !d_->frame_queue.push(std::move(queued), generation, st)) {
+        return false;
+    }
+    d_->reportMemory();
+    if (finished) {
+        d_->frame_queue.finish();
+        return false;
+    }
+    return true;
+}
+
+// 倒放：后台线程从当前位置起逐个向前取 GOP，从关键帧顺序解码一次并保留需要的帧，
+// 本线程按倒序转换后放入预读队列。返回 true 表示播放结束或被停止
+bool QmVideoDecoder::reverseDecodeLoop(std::stop_token st)
+{
+    struct Gop {
+        std::vector<QmVideoFrame> frames;
+        quint64 generation { 0 };
+        bool last { false };
+        qint64 bytes { 0 };
+    };
+    std::mutex gop_mutex;
+    std::condition_variable_any gop_cv;
+    std::deque<Gop> gops;
+    bool gop_done = false;
+    auto bytes_guard = qScopeGuard([this] {
+        d_->reverse_bytes = 0;
+    });
+
+    std::jthread gop_thread([this, &gop_mutex, &gop_cv, &gops, &gop_done](std::stop_token gop_st) {
+        auto done_guard = qScopeGuard([&] {
+            std::scoped_lock lock(gop_mutex);
+            gop_done = true;
+            gop_cv.notify_all();
+        });
+        quint64 generation = 0;
+        qint64 pos = -1;
+        {
+            std::scoped_lock lock(d_->decode_mutex);
+            generation = d_->frame_queue.generation();
+            pos = std::min(d_->frame_index, d_->index.frameCount() - 1);
+        }
+        while (!gop_st.stop_requested()) {
+            Gop gop;
+            {
+                std::scoped_lock lock(d_->decode_mutex);
+                // seekToFrame 之后从新位置开始，丢弃已预取的 GOP
+                if (d_->frame_queue.generation() != generation) {
+                    generation = d_->frame_queue.generation();
+                    pos = std::min(d_->frame_index, d_->index.frameCount() - 1);
+                    std::scoped_lock gop_lock(gop_mutex);
+                    for (const Gop& stale : gops) {
+                        d_->reverse_bytes -= stale.bytes;
+                    }
+                    gops.clear();
+                    gop_cv.notify_all();
+                }
+                gop.generation = generation;
+                const qint64 step = -d_->frame_step;
+                if (step <= 0 || d_->trick_speed > 1) {
+                    break;
+                }
+                if (pos < 0 && d_->loop) {
+                    pos = d_->index.frameCount() - 1;
+                }
+                if (pos < 0) {
+                    gop.last = true;
+                } else {
+                    const qint64 keyframe = std::max<qint64>(d_->index.keyframeBefore(pos), 0);
+                    if (seekToFrameImpl(keyframe)) {
+                        qint64 frame_no = -1;
+                        while (d_->decodeNext(&frame_no) >= 0 && frame_no <= pos) {
+                            if (frame_no >= keyframe && (pos - frame_no) % step == 0) {
+                                gop.frames.emplace_back(d_->frame, frame_no, d_->frameTimestamp(d_->frame));
+                                gop.bytes += gop.frames.back().byteSize();
+                            }
+                            if (frame_no == pos) {
+                                break;
+                            }
+                        }
+                    }
+                    // 下一个 GOP 中最后一个需要输出的帧
+                    pos -= ((pos - keyframe) / step + 1) * step;
+                    d_->frame_index = pos;
+                }
+            }
+            std::unique_lock lock(gop_mutex);
+            if (!gop_cv.wait(lock, gop_st, [&] { return gops.size() < static_cast<size_t>(d_->reverse_gop_count.load()); })) {
+                break;
+            }
+            const bool last = gop.last;
+            d_->reverse_bytes += gop.bytes;
+            gops.push_back(std::move(gop));
+            gop_cv.notify_all();
+            if (last) {
+                break;
+            }
+        }
+    });
+
+    qint64 last_frame_no = -1;
+    while (!st.stop_requested() && d_->frame_step < 0 && d_->trick_speed <= 1) {
+        Gop gop;
+        {
+            std::unique_lock lock(gop_mutex);
+            if (!gop_cv.wait(lock, st, [&gops, &gop_done] { return !gops.empty() || gop_done; })) {
+                return true;
+            }
+            if (gops.empty()) {
+                break;
+            }
+            gop = std::move(gops.front());
+            gops.pop_front();
+            d_->reverse_bytes -= gop.bytes;
+            gop_cv.notify_all();
+        }
+        if (gop.last) {
+            d_->frame_queue.finish();
+            return true;
+        }
+        for (auto it = gop.frames.rbegin(); it != gop.frames.rend(); ++it) {
+            QmQueuedFrame queued { d_->convertFrame(it->avFrame(), it->frameNumber()), it->frameNumber(), it->timestamp() };
+            queued.bytes = byteSizeOf(queued.data);
+            if (queued.data.isValid() && !d_->frame_queue.push(std::move(queued), gop.generation, st)) {
+                return true;
+            }
+            d_->reportMemory();
+            last_frame_no = it->frameNumber();
+        }
+    }
+    if (st.stop_requested()) {
+        return true;
+    }
+
+    // 切换回正向播放或关键帧模式，从最后输出的帧继续
+    gop_thread.request_stop();
+    gop_thread.join();
+    std::scoped_lock lock(d_->decode_mutex);
+    if (last_frame_no >= 0) {
+        d_->frame_index = last_frame_no + d_->frame_step;
+    }
+    std::ignore = seekToFrameImpl(d_->frame_index);
+    return false;
+}
+
+// 使用调度器时按需提交解码任务：预读队列处于填充阶段且没有在途任务时提交，
+// 截止时间为队列中已有的帧按当前速率播放完的时刻，非实时模式尽快解码
+void QmVideoDecoder::scheduleDecode()
+{
+    std::scoped_lock lock(d_->schedule_mutex);
+    if (d_->decode_stopped || !d_->frame_queue.canPush() || d_->decode_scheduled.exchange(true)) {
+        return;
+    }
+    qint64 deadline = QmDecoderScheduler::now();
+    if (d_->realtime) {
+        const double rate = std::max(std::abs(d_->playbackRate()), 0.01);
+        deadline += std::llround(d_->frame_queue.level() * AV_TIME_BASE / d_->fps / rate);
+    }
+    d_->stream_scheduler->post(d_->stream_id, deadline, [this] { decodeTask(); });
+}
+
+void QmVideoDecoder::decodeTask()
+{
+    const std::stop_token st = d_->stop_source.get_token();
+    for (int i = 0; i < kScheduledBatchFrames && !st.stop_requested() && d_->frame_queue.canPush(); ++i) {
+        if (!decodeStep(st, &d_->decode_trick_play)) {
+            std::scoped_lock lock(d_->schedule_mutex);
+            d_->decode_stopped = true;
+            break;
+        }
+    }
+    // 先清除在途标记再检查是否需要继续，避免与呈现线程的回填回调同时错过提交
+    d_->decode_scheduled = false;
+    scheduleDecode();
 }
 
 void QmVideoDecoder::run(std::stop_token st)
@@ -430,41 +1868,205 @@ void QmVideoDecoder::run(std::stop_token st)
         return;
     }
     d_->frame_index = (d_->frame_step < 0) ? d_->frame_count : 0;
-    QElapsedTimer elapsed_timer;
+    d_->frame_queue.clear();
+    // 解除上一次播放停止时的 abort；seek 中的 clear 不会解除，避免停止途中的 seek 让读取重新阻塞
+    d_->packet_queue.reset();
+    {
+        std::scoped_lock lock(d_->decode_mutex);
+        d_->pipeline_st = st;
+    }
 
-    auto frame_duration = std::chrono::duration<double, std::milli>(1000 / d_->fps);
-    std::chrono::steady_clock::time_point frame_time = std::chrono::steady_clock::now();
-    auto wait = [this, &st, &frame_time, &frame_duration] {
+    auto sleep_for = [this, &st](qint64 duration_us) {
         std::unique_lock<std::mutex> lock(d_->wait_mutex);
-        std::condition_variable_any().wait_until(lock, st, frame_time + frame_duration, [] { return false; });
-        frame_time = std::chrono::steady_clock::now();
+        std::condition_variable_any().wait_for(lock, st, std::chrono::microseconds(duration_us), [] { return false; });
     };
+    const qint64 frame_us = std::llround(AV_TIME_BASE / d_->fps);
+    d_->presented_count = 0;
+    d_->late_count = 0;
+    d_->dropped_count = 0;
+    d_->backpressure_dropped = 0;
 
-    while (!st.stop_requested()) {
-        elapsed_timer.restart();
+    // 有界投递：在途帧达到上限时 Block 等待消费者释放，LatestWins 只暂存最新一帧，有空位时再发出
+    QVariant pending;
+    QmFrameRing* ring = d_->frame_ring.get();
+    auto emit_frame = [this, ring, &st, &sleep_for](const QVariant& data) {
+        // 拉取模式：环形缓冲区满时等待消费者取走
+        if (ring) {
+            const QmVideoFrame frame = data.value<QmVideoFrame>();
+            if (frame.isNull()) {
+                return;
+            }
+            while (!ring->push(frame) && !st.stop_requested()) {
+                sleep_for(kDeliveryPollUs);
+            }
+            ++d_->presented_count;
+            return;
+        }
+        ++d_->presented_count;
+        if (d_->delivery_policy != UnboundedDelivery) {
+            emit frameReady(d_->delivery.track(data));
+        } else {
+            emit frameReady(data);
+        }
+    };
+    auto flush_pending = [this, &pending, &emit_frame] {
+        if (pending.isValid() && d_->delivery.hasSlot()) {
+            emit_frame(pending);
+            pending = QVariant();
+        }
+    };
+
+    // 解复用 -> 解码 -> 呈现 三级流水线：
+    // 解复用线程读取 packet 隐藏 I/O 延迟，解码线程提前填充预读队列，呈现线程只按节奏出队。
+    // 使用调度器时解码任务在共享线程中运行并同步读取 packet，预读队列回到填充阶段时重新提交；
+    // 倒放没有后台 GOP 线程，退回逐帧 seek
+    const bool scheduled = d_->stream_scheduler != nullptr;
+    std::jthread demux_thread;
+    std::jthread decode_thread;
+    if (scheduled) {
+        {
+            std::scoped_lock lock(d_->schedule_mutex);
+            d_->decode_stopped = false;
+            d_->decode_trick_play = false;
+        }
+        d_->frame_queue.setRefillCallback([this] { scheduleDecode(); });
+        scheduleDecode();
+    } else {
+        d_->demuxing = true;
+        demux_thread = std::jthread([this](std::stop_token demux_st) {
+            d_->demuxLoop(demux_st);
+        });
+        decode_thread = std::jthread([this](std::stop_token decode_st) {
+            decodeLoop(decode_st);
+        });
+    }
+    auto stop_pipeline = [this, &demux_thread, &decode_thread] {
+        {
+            std::scoped_lock lock(d_->schedule_mutex);
+            d_->decode_stopped = true;
+        }
+        demux_thread.request_stop();
+        decode_thread.request_stop();
+        d_->packet_queue.abort();
+    };
+    std::stop_callback stop_callback(st, stop_pipeline);
 
+    // 按帧的 pts 与呈现时钟对齐：内部时钟在开始播放、seek、循环回到开头时对齐到当前帧；
+    // 晚于呈现时刻超过一帧的帧直接丢弃，同时让解码线程跳过非参考帧以追上时钟
+    quint64 generation = d_->frame_queue.generation();
+    qint64 last_frame_no = -1;
+    qint64 last_pts = 0;
+    while (!st.stop_requested()) {
+        flush_pending();
         if (d_->state == Paused) {
-            wait();
+            d_->internal_clock.setPaused(true);
+            sleep_for(frame_us);
             continue;
-        } else {
-            int ret = 0;
-            auto frame_data = decodeFrame(d_->frame_index, &ret);
-            if (frame_data.isValid()) {
-                emit frameReady(frame_data);
+        }
+        d_->internal_clock.setPaused(false);
+        QmQueuedFrame queued;
+        if (!d_->frame_queue.pop(&queued, st)) {
+            break;
+        }
+        const qint64 pts = queued.timestamp >= 0 ? queued.timestamp : std::llround(queued.frame_no * AV_TIME_BASE / d_->fps);
+        QmVideoClock* clock = this->clock();
+        if (clock == &d_->internal_clock) {
+            const double rate = d_->playbackRate();
+            d_->internal_clock.setRate(rate);
+            // 帧号不再沿播放方向前进说明发生了 seek 或循环
+            const bool jumped = last_frame_no >= 0 && (queued.frame_no - last_frame_no) * rate <= 0;
+            if (last_frame_no < 0 || jumped || generation != d_->frame_queue.generation()) {
+                generation = d_->frame_queue.generation();
+                d_->internal_clock.setTime(pts);
             }
-            d_->frame_index += d_->frame_step;
-            if ((d_->frame_index > d_->frame_count || d_->frame_index < 0) || ret == AVERROR_EOF) {
-                if (d_->loop) {
-                    d_->frame_index = (d_->frame_step < 0) ? d_->frame_count : 0;
-                    std::ignore = seekToFrameImpl(d_->frame_index);
-                } else {
+        }
+        const qint64 frame_distance = last_frame_no >= 0 ? std::max(std::abs(pts - last_pts), frame_us) : frame_us;
+        last_frame_no = queued.frame_no;
+        last_pts = pts;
+
+        // 等待时钟走到该帧的 pts，非实时模式不等待也不丢帧
+        const bool realtime = d_->realtime;
+        double lateness_us = 0;
+        double rate = 1.0;
+        while (realtime && !st.stop_requested()) {
+            rate = clock->rate();
+            if (d_->state == Paused) {
+                d_->internal_clock.setPaused(true);
+            } else if (!clock->isPaused() && rate != 0) {
+                d_->internal_clock.setPaused(false);
+                const double delay_us = (pts - clock->time()) / rate;
+                if (delay_us <= 0) {
+                    lateness_us = -delay_us;
                     break;
                 }
+                flush_pending();
+                sleep_for(std::min<qint64>(std::llround(delay_us), kMaxClockWaitUs));
+                continue;
+            }
+            sleep_for(kMaxClockWaitUs);
+        }
+        if (st.stop_requested()) {
+            break;
+        }
+
+        const bool drop = realtime && lateness_us > frame_distance / std::abs(rate);
+        d_->catching_up = drop;
+        if (drop) {
+            ++d_->dropped_count;
+            continue;
+        }
+        if (lateness_us > kLateToleranceUs) {
+            ++d_->late_count;
+        }
+
+        const DeliveryPolicy policy = d_->delivery_policy;
+        if (policy == BlockDelivery) {
+            while (!st.stop_requested() && !d_->delivery.hasSlot()) {
+                sleep_for(kDeliveryPollUs);
+            }
+        } else if (policy == LatestWinsDelivery && !d_->delivery.hasSlot()) {
+            if (pending.isValid()) {
+                ++d_->backpressure_dropped;
             }
-            wait();
+            pending = std::move(queued.data);
+            continue;
+        }
+        if (st.stop_requested()) {
+            break;
+        }
+        emit_frame(queued.data);
+    }
+    // 播放结束时发出暂存的最后一帧；消费者长期持有帧时超时丢弃，保证 finished 能够发出
+    for (qint64 waited_us = 0; pending.isValid() && !st.stop_requested(); waited_us += kDeliveryPollUs) {
+        flush_pending();
+        if (!pending.isValid()) {
+            break;
         }
-        // qDebug() << "Elapsed: " << elapsed_timer.elapsed();
+        if (waited_us >= kFinalFlushTimeoutUs) {
+            ++d_->backpressure_dropped;
+            pending = QVariant();
+            break;
+        }
+        sleep_for(kDeliveryPollUs);
+    }
+    stop_pipeline();
+    if (scheduled) {
+        d_->frame_queue.setRefillCallback(nullptr);
+        d_->stream_scheduler->cancel(d_->stream_id);
+        d_->decode_scheduled = false;
+    } else {
+        decode_thread.join();
+        demux_thread.join();
+    }
+    {
+        std::scoped_lock lock(d_->decode_mutex);
+        d_->pipeline_st = {};
     }
+    d_->demuxing = false;
+    d_->catching_up = false;
+    d_->delivery.clear();
+    d_->packet_queue.clear();
+    d_->frame_queue.clear();
     d_->frame_index = (d_->frame_step < 0) ? d_->frame_count : 0;
     d_->state = Waiting;
 }
@@ -1,11 +1,18 @@
-#pragma
+#pragma once
 
+#include <QImage>
+#include <QList>
 #include <QObject>
+#include <QRect>
 #include <QVariant>
+#include <functional>
 #include <stop_token>
 
 #include "qmvideo_global.h"
 
+class QmDecoderScheduler;
+class QmVideoClock;
+class QmVideoFrame;
 struct QmVideoDecoderPrivate;
 
 class QMVIDEO_LIB_EXPORT QmVideoDecoder : public QObject {
@@ -19,14 +26,92 @@ public:
     };
 
     enum Format {
+        // 紧密排列的 yuv420p QByteArray
         Yuv420p,
         Image,
+        // QmVideoFrame，直接引用解码器输出的缓冲区，不做拷贝与转换
+        Frame,
+        // yuv420p 格式的 QmVideoFrame，保留各平面的行宽；源格式不同时转换到按 64 字节对齐的缓冲区
+        Yuv420pPlanar,
+        // nv12 格式的 QmVideoFrame，源格式一致时不做转换
+        Nv12,
+        // QImage::Format_RGBA8888
+        Rgba,
+        // QImage::Format_ARGB32，小端下内存顺序为 BGRA
+        Bgra,
+        // QImage::Format_Grayscale8，YUV 源直接引用亮度平面
+        Gray8,
     };
 
+    // 缩放算法，对应 swscale 的 SWS_* 标志
+    enum ScaleAlgorithm {
+        FastBilinear,
+        Bilinear,
+        Bicubic,
+        Area,
+        Lanczos,
+        Point,
+    };
+
+    enum IndexMode {
+        NoIndex,
+        // 首次 seek 时在后台建立关键帧索引，建好之前按帧率估算帧号与 seek 位置
+        LazyIndex,
+        IndexOnOpen,
+    };
+
+    enum ThreadingMode {
+        // 帧级 + 片级，由解码器自行选择
+        AutoThreading,
+        FrameThreading,
+        SliceThreading,
+        NoThreading,
+    };
+
+    // frameReady 的投递策略，在途帧指已发出但消费者尚未释放全部引用的帧
+    enum DeliveryPolicy {
+        // 不限制在途帧数
+        UnboundedDelivery,
+        // 在途帧达到上限时暂停呈现，直到消费者释放
+        BlockDelivery,
+        // 在途帧达到上限时只保留最新一帧，有空位时发出，被替换的帧计入丢弃
+        LatestWinsDelivery,
+    };
+
+    // 输出缓冲池统计
+    struct PoolStats {
+        qint64 hits { 0 };
+        qint64 misses { 0 };
+        qint64 bytes { 0 };
+        qint64 peak_bytes { 0 };
+    };
+
+    // 解码帧缓存统计
+    struct CacheStats {
+        qint64 hits { 0 };
+        qint64 misses { 0 };
+        qint64 bytes { 0 };
+        qint64 budget { 0 };
+        int frames { 0 };
+    };
+
+    // 播放呈现统计：迟到的帧仍会呈现，丢弃的帧不会发出 frameReady
+    struct PresentStats {
+        qint64 presented { 0 };
+        qint64 late { 0 };
+        qint64 dropped { 0 };
+        // 因在途帧达到上限而丢弃的帧
+        qint64 backpressure_dropped { 0 };
+    };
+
+    using FrameCallback = std::function<void(qint64 frame_no, const QVariant& frame)>;
+
     QmVideoDecoder();
     ~QmVideoDecoder() noexcept override;
 
     QSize size() const;
+    // 裁剪、缩放后的输出尺寸
+    QSize outputSize() const;
     QString path() const;
     State state() const;
     bool isPlaying() const;
@@ -34,15 +119,90 @@ public:
     bool isWaiting() const;
     double fps() const;
     qint64 frameCount() const;
+    // 实际生效的解码线程模式与线程数（open 之后有效）
+    ThreadingMode threadingMode() const;
+    int threadCount() const;
+    PoolStats poolStats() const;
+    CacheStats frameCacheStats() const;
+    PresentStats presentStats() const;
 
     bool open(const QString& video_path);
     void close();
     void setLoop(bool loop = true);
+    // frame_step < 0 时倒放：有关键帧索引时按 GOP 顺序解码一次再倒序输出
     void setFrameStep(qint64 frame_step);
-    void setOutputFormat(Format format);
+    // 关键帧快进/快退（如 8、16、32 倍速）：speed > 1 时只解码关键帧，呈现间隔按倍速缩短，方向由 frame_step 的符号决定
+    void setTrickPlaySpeed(int speed);
+    int trickPlaySpeed() const;
+    // 播放时按帧的 pts 与呈现时钟同步；设置外部时钟（如音频时钟）后由调用方驱动，clock 需在播放期间保持有效
+    // 为空时使用内部单调时钟，随播放、暂停、seek 自动调整
+    void setExternalClock(QmVideoClock* clock);
+    QmVideoClock* clock() const;
+    // 限制在途帧数，避免慢消费者导致帧在事件队列中无限堆积。max_in_flight 至少为 2（更小的值按 2 处理），
+    // 消费者可以保留当前显示的一帧（如 QmYuvView），但不能长期持有更多帧，否则 BlockDelivery 会一直等待
+    void setDeliveryPolicy(DeliveryPolicy policy, int max_in_flight = 2);
+    DeliveryPolicy deliveryPolicy() const;
+    int maxInFlightFrames() const;
+    int inFlightFrames() const;
+    // 关闭后不按时钟呈现，只受投递背压限速，尽快输出所有帧，用于分析等离线处理
+    void setRealtime(bool realtime);
+    bool isRealtime() const;
+    // 拉取模式：呈现线程把帧写入无锁单生产者/单消费者环形缓冲区，不再发出 frameReady，
+    // 省去每帧的 QVariant 拆装与跨线程事件。需在 play 之前设置，只支持输出 QmVideoFrame 的格式（Frame、Yuv420pPlanar、Nv12），其他格式下 setPullMode(true) 不生效
+    void setPullMode(bool enabled, int capacity = 8);
+    bool isPullMode() const;
+    // 取出一帧，timeout_ms <= 0 时不等待；同一时间只能有一个消费者线程调用
+    bool pullFrame(QmVideoFrame* frame, int timeout_ms = 0);
+    // 倒放时后台预取的 GOP 个数（默认 2），每个 GOP 的解码帧在输出前整体保留在内存中
+    void setReverseGopBufferCount(int count);
+    int reverseGopBufferCount() const;
+    // roi 为源画面中的裁剪区域（为空时不裁剪，左上角向下取偶数），size 为输出尺寸（为空时与裁剪区域相同）；
+    // 裁剪与缩放在格式转换的同一次 sws_scale 中完成。Frame 格式不做转换，只应用 roi
+    void setOutputFormat(Format format, const QSize& size = QSize(), const QRect& roi = QRect(), ScaleAlgorithm algorithm = FastBilinear);
+    // thread_count <= 0 表示使用 hardware_concurrency，需在 open 之前调用
+    void setThreading(ThreadingMode mode, int thread_count = 0);
+    // 多路同时播放时共享解码线程：播放期间不再创建解复用与解码线程，解码以任务形式提交到调度器，
+    // 按预读队列耗尽的时刻排序；此时 FFmpeg 内部只用单线程，setThreading 不生效。需在 open 之前调用，scheduler 需比解码器存活更久
+    void setScheduler(QmDecoderScheduler* scheduler);
+    QmDecoderScheduler* scheduler() const;
+    // 在调度器中注册的流 id，用于 QmDecoderScheduler::streamStats，未使用调度器或未打开时为 -1
+    int schedulerStream() const;
+    // open 后向进程级内存预算（QmMemoryBudget::instance）上报占用；超出预算时优先级低的先被回收：
+    // 依次淘汰帧缓存、释放缓冲池中的空闲缓冲区、减半预读深度，预算宽裕后恢复预读深度
+    void setMemoryPriority(int priority);
+    int memoryPriority() const;
+    // 当前占用的字节数，各类别明细见 QmMemoryBudget::clientStats(memoryClient())，未打开时 memoryClient 为 -1
+    qint64 memoryUsage() const;
+    int memoryClient() const;
+    // 关键帧索引用于精确到帧的 seek，并提供准确的帧数
+    void setIndexMode(IndexMode mode);
+    // 设置后索引保存到该目录，再次打开同一文件时直接映射缓存，无需重新扫描
+    void setIndexCacheDir(const QString& cache_dir);
+    // readFrame / readFrames 的解码帧 LRU 缓存，seek 途中解码的中间帧也会放入缓存，播放不写入；bytes <= 0 关闭
+    void setFrameCacheBudget(qint64 bytes);
+    // 预读队列：解码线程提前解码至多 depth 帧，达到高水位后暂停，回落到低水位后继续
+    void setLookaheadDepth(int depth);
+    void setLookaheadWatermarks(int low, int high);
+    int lookaheadDepth() const;
+    int lookaheadLevel() const;
+    // 解复用线程与解码线程之间的 packet 队列，按包数和字节数双重限制
+    void setPacketQueueLimits(int max_packets, qint64 max_bytes);
+    int packetQueueCount() const;
+    qint64 packetQueueBytes() const;
 
     void seekToFrame(qint64 frame_no);
     QVariant readFrame(qint64 frame_no);
+    QVariant readNextFrame();
+    // 批量读取：目标按帧号排序后顺序解码，同一 GOP 内的帧只需一次 seek；结果按传入顺序返回，失败的帧为无效 QVariant
+    QList<QVariant> readFrames(const QList<qint64>& frame_numbers);
+    // 每解码一帧回调一次，按帧号升序、重复的帧号只回调一次；回调时不持有解码锁
+    void readFrames(const QList<qint64>& frame_numbers, const FrameCallback& callback);
+    // 缩略图：取均匀分布的 count 个位置或每隔 interval_ms 一个位置，解码离其最近的关键帧，按比例缩放到 size 以内；
+    // 在独立的解码上下文中多线程提取，不影响当前播放与读取位置
+    QList<QImage> readThumbnails(int count, const QSize& size);
+    QList<QImage> readThumbnailsByInterval(qint64 interval_ms, const QSize& size);
+    // 只解码 frame_no 及之前最近的关键帧，用于拖动预览
+    QVariant readKeyframe(qint64 frame_no);
 
     void play();
     void resume();
@@ -56,9 +216,15 @@ signals:
 
 private:
     void run(std::stop_token st);
+    void decodeLoop(std::stop_token st);
+    bool decodeStep(std::stop_token st, bool* trick_play);
+    bool reverseDecodeLoop(std::stop_token st);
+    void scheduleDecode();
+    void decodeTask();
     bool seekToFrameImpl(qint64 frame_no);
-    QVariant nextFrame();
+    QVariant nextFrame(int* error = nullptr);
     QVariant decodeFrame(qint64 frame_no, int* error = nullptr);
+    QVariant decodeKeyframe(qint64 frame_no, bool backward, qint64* keyframe, int* error = nullptr);
 
 private:
     QmVideoDecoderPrivate* d_ { nullptr };
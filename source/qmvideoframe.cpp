@@ -0,0 +1,198 @@
+#include "qmvideoframe.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+struct QmVideoFrameData {
+    AVFrame* frame { nullptr };
+    qint64 frame_no { -1 };
+    qint64 timestamp_us { -1 };
+    std::shared_ptr<void> release_token;
+
+    ~QmVideoFrameData() noexcept
+    {
+        av_frame_free(&frame);
+    }
+};
+
+QmVideoFrame::QmVideoFrame() = default;
+
+QmVideoFrame::QmVideoFrame(const AVFrame* frame, qint64 frame_no, qint64 timestamp_us)
+{
+    if (!frame) {
+        return;
+    }
+    auto data = std::make_shared<QmVideoFrameData>();
+    data->frame = av_frame_alloc();
+    if (!data->frame || av_frame_ref(data->frame, frame) < 0) {
+        return;
+    }
+    data->frame_no = frame_no;
+    data->timestamp_us = timestamp_us;
+    d_ = std::move(data);
+}
+
+bool QmVideoFrame::isNull() const
+{
+    return !d_;
+}
+
+bool QmVideoFrame::isDetached() const
+{
+    return d_.use_count() <= 1;
+}
+
+QSize QmVideoFrame::size() const
+{
+    return d_ ? QSize(d_->frame->width, d_->frame->height) : QSize();
+}
+
+int QmVideoFrame::width() const
+{
+    return d_ ? d_->frame->width : 0;
+}
+
+int QmVideoFrame::height() const
+{
+    return d_ ? d_->frame->height : 0;
+}
+
+int QmVideoFrame::pixelFormat() const
+{
+    return d_ ? d_->frame->format : AV_PIX_FMT_NONE;
+}
+
+bool QmVideoFrame::isKeyFrame() const
+{
+#ifdef AV_FRAME_FLAG_KEY
+    return d_ && (d_->frame->flags & AV_FRAME_FLAG_KEY);
+#else
+    return d_ && d_->frame->key_frame;
+#endif
+}
+
+int QmVideoFrame::planeCount() const
+{
+    if (!d_) {
+        return 0;
+    }
+    return std::max(av_pix_fmt_count_planes(static_cast<AVPixelFormat>(d_->frame->format)), 0);
+}
+
+QSize QmVideoFrame::planeSize(int plane) const
+{
+    if (plane < 0 || plane >= planeCount()) {
+        return {};
+    }
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(d_->frame->format));
+    if (plane == 0 || plane == 3 || !desc) {
+        return size();
+    }
+    return { AV_CEIL_RSHIFT(d_->frame->width, desc->log2_chroma_w), AV_CEIL_RSHIFT(d_->frame->height, desc->log2_chroma_h) };
+}
+
+const uchar* QmVideoFrame::constBits(int plane) const
+{
+    if (!d_ || plane < 0 || plane >= AV_NUM_DATA_POINTERS) {
+        return nullptr;
+    }
+    return d_->frame->data[plane];
+}
+
+int QmVideoFrame::bytesPerLine(int plane) const
+{
+    if (!d_ || plane < 0 || plane >= AV_NUM_DATA_POINTERS) {
+        return 0;
+    }
+    return d_->frame->linesize[plane];
+}
+
+qint64 QmVideoFrame::pts() const
+{
+    return d_ ? d_->frame->best_effort_timestamp : AV_NOPTS_VALUE;
+}
+
+qint64 QmVideoFrame::timestamp() const
+{
+    return d_ ? d_->timestamp_us : -1;
+}
+
+qint64 QmVideoFrame::frameNumber() const
+{
+    return d_ ? d_->frame_no : -1;
+}
+
+qint64 QmVideoFrame::byteSize() const
+{
+    if (!d_) {
+        return 0;
+    }
+    qint64 bytes = 0;
+    for (const AVBufferRef* buf : d_->frame->buf) {
+        if (buf) {
+            bytes += static_cast<qint64>(buf->size);
+        }
+    }
+    return bytes;
+}
+
+const AVFrame* QmVideoFrame::avFrame() const
+{
+    return d_ ? d_->frame : nullptr;
+}
+
+QmVideoFrame QmVideoFrame::copy(int align) const
+{
+    if (!d_) {
+        return {};
+    }
+    AVFrame* frame = av_frame_alloc();
+    frame->format = d_->frame->format;
+    frame->width = d_->frame->width;
+    frame->height = d_->frame->height;
+    QmVideoFrame result;
+    if (av_frame_get_buffer(frame, align) >= 0 && av_frame_copy(frame, d_->frame) >= 0) {
+        av_frame_copy_props(frame, d_->frame);
+        result = QmVideoFrame(frame, d_->frame_no, d_->timestamp_us);
+    }
+    av_frame_free(&frame);
+    return result;
+}
+
+QmVideoFrame QmVideoFrame::withReleaseToken(std::shared_ptr<void> token) const
+{
+    if (!d_) {
+        return {};
+    }
+    auto data = std::make_shared<QmVideoFrameData>();
+    data->frame = av_frame_alloc();
+    if (!data->frame || av_frame_ref(data->frame, d_->frame) < 0) {
+        return {};
+    }
+    data->frame_no = d_->frame_no;
+    data->timestamp_us = d_->timestamp_us;
+    data->release_token = std::move(token);
+    QmVideoFrame result;
+    result.d_ = std::move(data);
+    return result;
+}
+
+QByteArray QmVideoFrame::toPacked() const
+{
+    if (!d_) {
+        return {};
+    }
+    const auto format = static_cast<AVPixelFormat>(d_->frame->format);
+    const int size = av_image_get_buffer_size(format, d_->frame->width, d_->frame->height, 1);
+    if (size <= 0) {
+        return {};
+    }
+    QByteArray packed(size, Qt::Uninitialized);
+    if (av_image_copy_to_buffer(reinterpret_cast<uint8_t*>(packed.data()), size, d_->frame->data, d_->frame->linesize, format, d_->frame->width, d_->frame->height, 1) < 0) {
+        return {};
+    }
+    return packed;
+}
\ No newline at end of file
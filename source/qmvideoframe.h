@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QSize>
+#include <memory>
+
+#include "qmvideo_global.h"
+
+struct AVFrame;
+struct QmVideoFrameData;
+
+// 引用计数的解码帧句柄
+// 内部通过 av_frame_ref 持有解码器输出的缓冲区，拷贝句柄不会拷贝像素数据，
+// 最后一个句柄析构时缓冲区才归还给解码器
+class QMVIDEO_LIB_EXPORT QmVideoFrame {
+public:
+    // 深拷贝时默认的行对齐字节数，满足 AVX-512 对齐要求
+    static constexpr int kDefaultAlignment = 64;
+
+    QmVideoFrame();
+    // timestamp_us 为相对于流起点的显示时间（微秒）
+    explicit QmVideoFrame(const AVFrame* frame, qint64 frame_no = -1, qint64 timestamp_us = -1);
+
+    bool isNull() const;
+    // 没有其他句柄引用同一帧
+    bool isDetached() const;
+    QSize size() const;
+    int width() const;
+    int height() const;
+    // AVPixelFormat
+    int pixelFormat() const;
+    bool isKeyFrame() const;
+
+    int planeCount() const;
+    QSize planeSize(int plane) const;
+    const uchar* constBits(int plane) const;
+    int bytesPerLine(int plane) const;
+
+    // 流时间基下的原始 pts
+    qint64 pts() const;
+    qint64 timestamp() const;
+    qint64 frameNumber() const;
+    // 引用的缓冲区总字节数
+    qint64 byteSize() const;
+
+    const AVFrame* avFrame() const;
+
+    // 深拷贝，每个平面的行宽按 align 字节对齐
+    QmVideoFrame copy(int align = kDefaultAlignment) const;
+    // 引用同一缓冲区的新句柄，新句柄及其全部拷贝析构后才释放 token，用于得知消费者何时释放了帧
+    QmVideoFrame withReleaseToken(std::shared_ptr<void> token) const;
+    // 逐行拷贝为紧密排列（linesize == 宽度）的连续缓冲区，仅在调用方确实需要时使用
+    QByteArray toPacked() const;
+
+private:
+    std::shared_ptr<const QmVideoFrameData> d_;
+};
+
+Q_DECLARE_METATYPE(QmVideoFrame)
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "qmvideoindex.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QScopeGuard>
+#include <algorithm>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace {
+constexpr char kCacheMagic[8] = { 'Q', 'M', 'V', 'I', 'D', 'X', '\0', '\0' };
+constexpr quint32 kCacheVersion = 1;
+// 用于识别字节序不同的机器上生成的缓存
+constexpr quint32 kByteOrderMark = 0x01020304;
+
+struct CacheHeader {
+    char magic[8];
+    quint32 version;
+    quint32 byte_order;
+    quint64 frame_count;
+    quint64 keyframe_count;
+};
+static_assert(sizeof(CacheHeader) % sizeof(qint64) == 0);
+}
+
+QmVideoIndex::QmVideoIndex() = default;
+
+QmVideoIndex::~QmVideoIndex() noexcept = default;
+
+QmVideoIndex::QmVideoIndex(QmVideoIndex&& other) noexcept = default;
+
+QmVideoIndex& QmVideoIndex::operator=(QmVideoIndex&& other) noexcept = default;
+
+bool QmVideoIndex::build(const QString& video_path, int stream_index, std::stop_token st)
+{
+    clear();
+
+    QElapsedTimer elapsed_timer;
+    elapsed_timer.start();
+    AVFormatContext* fmt_ctx = nullptr;
+    AVPacket* packet = av_packet_alloc();
+    auto guard = qScopeGuard([&] {
+        av_packet_free(&packet);
+        avformat_close_input(&fmt_ctx);
+    });
+    if (avformat_open_input(&fmt_ctx, video_path.toStdString().c_str(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx, nullptr) < 0 || stream_index < 0 || stream_index >= static_cast<int>(fmt_ctx->nb_streams)) {
+        return false;
+    }
+    // 只关心视频流，其余流直接在解复用层丢弃
+    for (unsigned i = 0; i < fmt_ctx->nb_streams; ++i) {
+        if (static_cast<int>(i) != stream_index) {
+            fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    std::vector<qint64> keyframe_pts;
+    while (!st.stop_requested() && av_read_frame(fmt_ctx, packet) >= 0) {
+        if (packet->stream_index == stream_index) {
+            const qint64 pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            if (pts != AV_NOPTS_VALUE && !(packet->flags & AV_PKT_FLAG_DISCARD)) {
+                pts_storage_.push_back(pts);
+                if (packet->flags & AV_PKT_FLAG_KEY) {
+                    keyframe_pts.push_back(pts);
+                }
+            }
+        }
+        av_packet_unref(packet);
+    }
+    if (st.stop_requested()) {
+        clear();
+        return false;
+    }
+
+    // packet 按解码顺序读出，排序后即为显示顺序
+    std::sort(pts_storage_.begin(), pts_storage_.end());
+    pts_storage_.erase(std::unique(pts_storage_.begin(), pts_storage_.end()), pts_storage_.end());
+    pts_ = pts_storage_;
+    keyframe_storage_.reserve(keyframe_pts.size());
+    for (qint64 pts : keyframe_pts) {
+        keyframe_storage_.push_back(frameOfPts(pts));
+    }
+    std::sort(keyframe_storage_.begin(), keyframe_storage_.end());
+    keyframe_storage_.erase(std::unique(keyframe_storage_.begin(), keyframe_storage_.end()), keyframe_storage_.end());
+    keyframes_ = keyframe_storage_;
+
+    qDebug() << "QmVideoIndex::build. frames:" << static_cast<qint64>(pts_.size())
+             << "keyframes:" << static_cast<qint64>(keyframes_.size())
+             << "elapsed:" << elapsed_timer.elapsed() << "ms";
+    if (keyframes_.empty()) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void QmVideoIndex::clear()
+{
+    pts_ = {};
+    keyframes_ = {};
+    pts_storage_.clear();
+    keyframe_storage_.clear();
+    mapped_file_.reset();
+}
+
+QString QmVideoIndex::cacheFilePath(const QString& cache_dir, const QString& video_path, int stream_index)
+{
+    const QFileInfo info(video_path);
+    if (cache_dir.isEmpty() || !info.exists()) {
+        return {};
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(info.absoluteFilePath().toUtf8());
+    hash.addData(QByteArray::number(info.size()));
+    hash.addData(QByteArray::number(info.lastModified().toMSecsSinceEpoch()));
+    hash.addData(QByteArray::number(stream_index));
+    return QDir(cache_dir).filePath(QString::fromLatin1(hash.result().toHex()) + ".qmidx");
+}
+
+bool QmVideoIndex::load(const QString& cache_file)
+{
+    clear();
+    auto file = std::make_unique<QFile>(cache_file);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < static_cast<qint64>(sizeof(CacheHeader))) {
+        return false;
+    }
+    uchar* data = file->map(0, file->size());
+    if (!data) {
+        return false;
+    }
+    CacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    // 先限制数量再计算大小，避免损坏的计数溢出
+    const quint64 max_count = static_cast<quint64>(file->size()) / sizeof(qint64);
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 || header.version != kCacheVersion
+        || header.byte_order != kByteOrderMark || header.keyframe_count == 0 || header.keyframe_count > header.frame_count
+        || header.frame_count > max_count
+        || static_cast<quint64>(file->size()) != sizeof(CacheHeader) + (header.frame_count + header.keyframe_count) * sizeof(qint64)) {
+        return false;
+    }
+    // 映射地址按页对齐，头部大小是 8 的倍数，可以直接按 qint64 访问
+    const auto* values = reinterpret_cast<const qint64*>(data + sizeof(CacheHeader));
+    const std::span<const qint64> pts { values, static_cast<size_t>(header.frame_count) };
+    const std::span<const qint64> keyframes { values + header.frame_count, static_cast<size_t>(header.keyframe_count) };
+    // 查找依赖二分，pts 与关键帧帧号必须严格递增，关键帧帧号必须落在帧范围内
+    const auto not_increasing = [](qint64 prev, qint64 next) {
+        return prev >= next;
+    };
+    if (std::adjacent_find(pts.begin(), pts.end(), not_increasing) != pts.end()
+        || std::adjacent_find(keyframes.begin(), keyframes.end(), not_increasing) != keyframes.end()
+        || keyframes.front() < 0 || keyframes.back() >= static_cast<qint64>(header.frame_count)) {
+        qDebug() << "QmVideoIndex::load. corrupt index cache:" << cache_file;
+        return false;
+    }
+    pts_ = pts;
+    keyframes_ = keyframes;
+    mapped_file_ = std::move(file);
+    return true;
+}
+
+bool QmVideoIndex::save(const QString& cache_file) const
+{
+    if (!isValid() || cache_file.isEmpty()) {
+        return false;
+    }
+    QDir().mkpath(QFileInfo(cache_file).absolutePath());
+    QSaveFile file(cache_file);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    CacheHeader header {};
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    header.byte_order = kByteOrderMark;
+    header.frame_count = pts_.size();
+    header.keyframe_count = keyframes_.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(pts_.data()), pts_.size_bytes());
+    file.write(reinterpret_cast<const char*>(keyframes_.data()), keyframes_.size_bytes());
+    return file.commit();
+}
+
+bool QmVideoIndex::isValid() const
+{
+    return !pts_.empty() && !keyframes_.empty();
+}
+
+qint64 QmVideoIndex::frameCount() const
+{
+    return static_cast<qint64>(pts_.size());
+}
+
+qint64 QmVideoIndex::ptsOfFrame(qint64 frame_no) const
+{
+    if (frame_no < 0 || frame_no >= frameCount()) {
+        return AV_NOPTS_VALUE;
+    }
+    return pts_[frame_no];
+}
+
+qint64 QmVideoIndex::frameOfPts(qint64 pts) const
+{
+    return std::lower_bound(pts_.begin(), pts_.end(), pts) - pts_.begin();
+}
+
+qint64 QmVideoIndex::keyframeBefore(qint64 frame_no) const
+{
+    auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), frame_no);
+    if (it == keyframes_.begin()) {
+        return -1;
+    }
+    return *(--it);
+}
+
+qint64 QmVideoIndex::keyframeAfter(qint64 frame_no) const
+{
+    auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), frame_no);
+    return it == keyframes_.end() ? -1 : *it;
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QString>
+#include <memory>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+class QFile;
+
+// 视频流的帧/关键帧索引
+// 帧号按显示顺序（pts 升序）编号，用于帧号与 pts 的互相换算以及查找最近的前一个关键帧
+class QmVideoIndex {
+public:
+    QmVideoIndex();
+    ~QmVideoIndex() noexcept;
+    Q_DISABLE_COPY(QmVideoIndex)
+    // 移动不改变 vector 与映射文件的地址，pts_ / keyframes_ 仍然有效
+    QmVideoIndex(QmVideoIndex&& other) noexcept;
+    QmVideoIndex& operator=(QmVideoIndex&& other) noexcept;
+
+    // 单独打开一个 AVFormatContext 扫描 packet，不影响正在解码的上下文；可通过 st 中途取消
+    bool build(const QString& video_path, int stream_index, std::stop_token st = {});
+    void clear();
+
+    // 索引缓存文件：以路径、文件大小、修改时间与流序号为键，内容可直接内存映射
+    static QString cacheFilePath(const QString& cache_dir, const QString& video_path, int stream_index);
+    bool load(const QString& cache_file);
+    bool save(const QString& cache_file) const;
+
+    bool isValid() const;
+    qint64 frameCount() const;
+    // 越界时返回 AV_NOPTS_VALUE
+    qint64 ptsOfFrame(qint64 frame_no) const;
+    // pts 不小于给定值的第一帧
+    qint64 frameOfPts(qint64 pts) const;
+    // 不晚于 frame_no 的最近关键帧，没有时返回 -1
+    qint64 keyframeBefore(qint64 frame_no) const;
+    // 晚于 frame_no 的下一个关键帧，没有时返回 -1
+    qint64 keyframeAfter(qint64 frame_no) const;
+
+private:
+    // 按显示顺序排列的 pts
+    std::span<const qint64> pts_;
+    // 关键帧帧号，升序
+    std::span<const qint64> keyframes_;
+
+    // build 得到的索引保存在 vector 中，load 得到的索引直接指向映射的文件内容
+    std::vector<qint64> pts_storage_;
+    std::vector<qint64> keyframe_storage_;
+    std::unique_ptr<QFile> mapped_file_;
+};
\ No newline at end of file
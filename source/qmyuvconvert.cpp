@@ -0,0 +1,275 @@
+#include "qmyuvconvert.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define QM_YUV_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define QM_TARGET(isa)
+#else
+#define QM_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace {
+// 亮度与色度先左移 7 位，与 Q13 系数做 mulhrs 后得到 Q5 的分量，16 位内不会溢出
+struct Coefficients {
+    int16_t y_offset;
+    int16_t y;
+    int16_t v_r;
+    int16_t u_g;
+    int16_t v_g;
+    int16_t u_b;
+};
+
+Coefficients coefficientsOf(QmYuvConvert::ColorSpace space, QmYuvConvert::ColorRange range)
+{
+    const double kr = (space == QmYuvConvert::Bt709) ? 0.2126 : 0.299;
+    const double kb = (space == QmYuvConvert::Bt709) ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+    const bool limited = range == QmYuvConvert::LimitedRange;
+    const double y_scale = limited ? 255.0 / 219.0 : 1.0;
+    const double c_scale = limited ? 255.0 / 224.0 : 1.0;
+    auto q13 = [](double value) { return static_cast<int16_t>(std::lround(value * 8192)); };
+    return {
+        static_cast<int16_t>(limited ? 16 : 0),
+        q13(y_scale),
+        q13(2 * (1 - kr) * c_scale),
+        q13(2 * (1 - kb) * kb / kg * c_scale),
+        q13(2 * (1 - kr) * kr / kg * c_scale),
+        q13(2 * (1 - kb) * c_scale),
+    };
+}
+
+int bytesPerPixel(QmYuvConvert::PixelFormat format)
+{
+    return format == QmYuvConvert::Rgb24 ? 3 : 4;
+}
+
+// 与 _mm_mulhrs_epi16 的舍入一致
+inline int mulhrs(int a, int b)
+{
+    return (a * b + 0x4000) >> 15;
+}
+
+inline uint8_t toPixel(int value)
+{
+    return static_cast<uint8_t>(std::clamp((value + 16) >> 5, 0, 255));
+}
+
+void convertRowScalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int x, int width,
+    QmYuvConvert::PixelFormat format, const Coefficients& c)
+{
+    const int bpp = bytesPerPixel(format);
+    const int r_pos = (format == QmYuvConvert::Bgra) ? 2 : 0;
+    const int b_pos = 2 - r_pos;
+    for (; x < width; ++x) {
+        const int yy = mulhrs((y[x] - c.y_offset) * 128, c.y);
+        const int uu = (u[x / 2] - 128) * 128;
+        const int vv = (v[x / 2] - 128) * 128;
+        uint8_t* p = dst + x * bpp;
+        p[r_pos] = toPixel(yy + mulhrs(vv, c.v_r));
+        p[1] = toPixel(yy - (mulhrs(uu, c.u_g) + mulhrs(vv, c.v_g)));
+        p[b_pos] = toPixel(yy + mulhrs(uu, c.u_b));
+        if (bpp == 4) {
+            p[3] = 255;
+        }
+    }
+}
+
+#ifdef QM_YUV_X86
+QM_TARGET("sse4.1")
+inline __m128i packChannel(__m128i lo, __m128i hi, __m128i round)
+{
+    return _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(lo, round), 5), _mm_srai_epi16(_mm_add_epi16(hi, round), 5));
+}
+
+// 16 个像素的三个通道按 c0 c1 c2 [A] 交织写出，c0 为内存中的第一个字节
+// Rgb24 每 4 个像素写 16 字节，末尾 4 字节由后续写入覆盖
+QM_TARGET("sse4.1")
+inline void storePixels(uint8_t* dst, __m128i c0, __m128i c1, __m128i c2, bool rgb24)
+{
+    const __m128i alpha = _mm_set1_epi8(-1);
+    const __m128i c01_lo = _mm_unpacklo_epi8(c0, c1);
+    const __m128i c01_hi = _mm_unpackhi_epi8(c0, c1);
+    const __m128i c2a_lo = _mm_unpacklo_epi8(c2, alpha);
+    const __m128i c2a_hi = _mm_unpackhi_epi8(c2, alpha);
+    const __m128i pixels[4] = {
+        _mm_unpacklo_epi16(c01_lo, c2a_lo),
+        _mm_unpackhi_epi16(c01_lo, c2a_lo),
+        _mm_unpacklo_epi16(c01_hi, c2a_hi),
+        _mm_unpackhi_epi16(c01_hi, c2a_hi),
+    };
+    if (rgb24) {
+        const __m128i drop_alpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        for (int i = 0; i < 4; ++i) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 12), _mm_shuffle_epi8(pixels[i], drop_alpha));
+        }
+    } else {
+        for (int i = 0; i < 4; ++i) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 16), pixels[i]);
+        }
+    }
+}
+
+QM_TARGET("sse4.1")
+inline void storeRgb(uint8_t* dst, __m128i r, __m128i g, __m128i b, QmYuvConvert::PixelFormat format)
+{
+    if (format == QmYuvConvert::Bgra) {
+        storePixels(dst, b, g, r, false);
+    } else {
+        storePixels(dst, r, g, b, format == QmYuvConvert::Rgb24);
+    }
+}
+
+// Rgb24 的最后一次写入越过本组输出 4 字节，需要至少再有 2 个像素
+int simdLimit(int width, int step, QmYuvConvert::PixelFormat format)
+{
+    return width - step - (format == QmYuvConvert::Rgb24 ? 2 : 0);
+}
+
+QM_TARGET("sse4.1")
+int convertRowSse41(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int x, int width,
+    QmYuvConvert::PixelFormat format, const Coefficients& c)
+{
+    const int bpp = bytesPerPixel(format);
+    const int limit = simdLimit(width, 16, format);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i y_offset = _mm_set1_epi16(c.y_offset);
+    const __m128i uv_offset = _mm_set1_epi16(128);
+    const __m128i round = _mm_set1_epi16(16);
+    const __m128i c_y = _mm_set1_epi16(c.y);
+    const __m128i c_vr = _mm_set1_epi16(c.v_r);
+    const __m128i c_ug = _mm_set1_epi16(c.u_g);
+    const __m128i c_vg = _mm_set1_epi16(c.v_g);
+    const __m128i c_ub = _mm_set1_epi16(c.u_b);
+    for (; x <= limit; x += 16) {
+        const __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+        const __m128i u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2));
+        const __m128i v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2));
+        const __m128i uu = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(u8, zero), uv_offset), 7);
+        const __m128i vv = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(v8, zero), uv_offset), 7);
+        // 色度项按色度分辨率计算，再复制到相邻的两个像素
+        const __m128i r_c = _mm_mulhrs_epi16(vv, c_vr);
+        const __m128i g_c = _mm_add_epi16(_mm_mulhrs_epi16(uu, c_ug), _mm_mulhrs_epi16(vv, c_vg));
+        const __m128i b_c = _mm_mulhrs_epi16(uu, c_ub);
+        const __m128i y_lo = _mm_mulhrs_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), y_offset), 7), c_y);
+        const __m128i y_hi = _mm_mulhrs_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y8, zero), y_offset), 7), c_y);
+        const __m128i r = packChannel(_mm_add_epi16(y_lo, _mm_unpacklo_epi16(r_c, r_c)), _mm_add_epi16(y_hi, _mm_unpackhi_epi16(r_c, r_c)), round);
+        const __m128i g = packChannel(_mm_sub_epi16(y_lo, _mm_unpacklo_epi16(g_c, g_c)), _mm_sub_epi16(y_hi, _mm_unpackhi_epi16(g_c, g_c)), round);
+        const __m128i b = packChannel(_mm_add_epi16(y_lo, _mm_unpacklo_epi16(b_c, b_c)), _mm_add_epi16(y_hi, _mm_unpackhi_epi16(b_c, b_c)), round);
+        storeRgb(dst + x * bpp, r, g, b, format);
+    }
+    return x;
+}
+
+QM_TARGET("avx2")
+inline __m256i packChannel(__m256i lo, __m256i hi, __m256i round)
+{
+    // packus 在 128 位通道内交错，调整 64 位块恢复像素顺序
+    const __m256i packed = _mm256_packus_epi16(_mm256_srai_epi16(_mm256_add_epi16(lo, round), 5), _mm256_srai_epi16(_mm256_add_epi16(hi, round), 5));
+    return _mm256_permute4x64_epi64(packed, 0xD8);
+}
+
+QM_TARGET("avx2")
+int convertRowAvx2(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, int x, int width,
+    QmYuvConvert::PixelFormat format, const Coefficients& c)
+{
+    const int bpp = bytesPerPixel(format);
+    const int limit = simdLimit(width, 32, format);
+    const __m256i y_offset = _mm256_set1_epi16(c.y_offset);
+    const __m256i uv_offset = _mm256_set1_epi16(128);
+    const __m256i round = _mm256_set1_epi16(16);
+    const __m256i c_y = _mm256_set1_epi16(c.y);
+    const __m256i c_vr = _mm256_set1_epi16(c.v_r);
+    const __m256i c_ug = _mm256_set1_epi16(c.u_g);
+    const __m256i c_vg = _mm256_set1_epi16(c.v_g);
+    const __m256i c_ub = _mm256_set1_epi16(c.u_b);
+    for (; x <= limit; x += 32) {
+        const __m256i uu = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x / 2))), uv_offset), 7);
+        const __m256i vv = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x / 2))), uv_offset), 7);
+        // 色度 0-3,8-11 | 4-7,12-15 排列后，通道内 unpack 得到像素 0-15 与 16-31
+        const __m256i r_c = _mm256_permute4x64_epi64(_mm256_mulhrs_epi16(vv, c_vr), 0xD8);
+        const __m256i g_c = _mm256_permute4x64_epi64(_mm256_add_epi16(_mm256_mulhrs_epi16(uu, c_ug), _mm256_mulhrs_epi16(vv, c_vg)), 0xD8);
+        const __m256i b_c = _mm256_permute4x64_epi64(_mm256_mulhrs_epi16(uu, c_ub), 0xD8);
+        const __m256i y_lo = _mm256_mulhrs_epi16(_mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x))), y_offset), 7), c_y);
+        const __m256i y_hi = _mm256_mulhrs_epi16(_mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x + 16))), y_offset), 7), c_y);
+        const __m256i r = packChannel(_mm256_add_epi16(y_lo, _mm256_unpacklo_epi16(r_c, r_c)), _mm256_add_epi16(y_hi, _mm256_unpackhi_epi16(r_c, r_c)), round);
+        const __m256i g = packChannel(_mm256_sub_epi16(y_lo, _mm256_unpacklo_epi16(g_c, g_c)), _mm256_sub_epi16(y_hi, _mm256_unpackhi_epi16(g_c, g_c)), round);
+        const __m256i b = packChannel(_mm256_add_epi16(y_lo, _mm256_unpacklo_epi16(b_c, b_c)), _mm256_add_epi16(y_hi, _mm256_unpackhi_epi16(b_c, b_c)), round);
+        storeRgb(dst + x * bpp, _mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b), format);
+        storeRgb(dst + (x + 16) * bpp, _mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1), _mm256_extracti128_si256(b, 1), format);
+    }
+    return x;
+}
+#endif
+
+QmYuvConvert::Isa detectIsa()
+{
+#ifdef QM_YUV_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] {};
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+    __cpuid(info, 1);
+    const bool sse41 = info[2] & (1 << 19);
+    // OSXSAVE 与 AVX 位均置位且系统保存了 YMM 寄存器
+    const bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (os_avx && max_leaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = info[1] & (1 << 5);
+    }
+#else
+    __builtin_cpu_init();
+    const bool sse41 = __builtin_cpu_supports("sse4.1");
+    const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2) {
+        return QmYuvConvert::Avx2Isa;
+    }
+    if (sse41) {
+        return QmYuvConvert::Sse41Isa;
+    }
+#endif
+    return QmYuvConvert::ScalarIsa;
+}
+}
+
+QmYuvConvert::Isa QmYuvConvert::detectedIsa()
+{
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+void QmYuvConvert::convert(const uint8_t* const src[3], const int src_stride[3], uint8_t* dst, int dst_stride, int width, int height,
+    PixelFormat format, ColorSpace space, ColorRange range, Isa isa)
+{
+    if (!src || !dst || width <= 0 || height <= 0) {
+        return;
+    }
+    const Isa available = detectedIsa();
+    if (isa == AutoIsa || isa > available) {
+        isa = available;
+    }
+    const Coefficients c = coefficientsOf(space, range);
+    for (int row = 0; row < height; ++row) {
+        const uint8_t* y = src[0] + static_cast<ptrdiff_t>(row) * src_stride[0];
+        const uint8_t* u = src[1] + static_cast<ptrdiff_t>(row / 2) * src_stride[1];
+        const uint8_t* v = src[2] + static_cast<ptrdiff_t>(row / 2) * src_stride[2];
+        uint8_t* out = dst + static_cast<ptrdiff_t>(row) * dst_stride;
+        int x = 0;
+#ifdef QM_YUV_X86
+        if (isa == Avx2Isa) {
+            x = convertRowAvx2(y, u, v, out, x, width, format, c);
+        }
+        if (isa >= Sse41Isa) {
+            x = convertRowSse41(y, u, v, out, x, width, format, c);
+        }
+#endif
+        convertRowScalar(y, u, v, out, x, width, format, c);
+    }
+}
\ No newline at end of file
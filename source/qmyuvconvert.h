@@ -0,0 +1,46 @@
+#pragma once
+
+#include "qmvideo_global.h"
+#include <cstdint>
+
+// yuv420p 到 8 位 RGB 的同尺寸转换，直接写入目标缓冲区
+// 系数为 Q13 定点数，SIMD 实现与标量实现逐位一致，运行时按 CPU 支持的指令集选择
+class QMVIDEO_LIB_EXPORT QmYuvConvert {
+public:
+    enum ColorSpace {
+        Bt601,
+        Bt709,
+    };
+
+    enum ColorRange {
+        // Y: 16-235，UV: 16-240
+        LimitedRange,
+        // Y/UV: 0-255
+        FullRange,
+    };
+
+    enum PixelFormat {
+        // R G B，对应 QImage::Format_RGB888
+        Rgb24,
+        // R G B A，对应 QImage::Format_RGBA8888
+        Rgba,
+        // B G R A，小端下对应 QImage::Format_ARGB32
+        Bgra,
+    };
+
+    enum Isa {
+        // 运行时检测
+        AutoIsa,
+        ScalarIsa,
+        Sse41Isa,
+        Avx2Isa,
+    };
+
+    // 当前 CPU 可用的最高指令集
+    static Isa detectedIsa();
+
+    // width/height 为亮度平面尺寸，奇数尺寸时色度按向下取整的位置取样
+    // isa 高于 detectedIsa() 时退回到可用的实现
+    static void convert(const uint8_t* const src[3], const int src_stride[3], uint8_t* dst, int dst_stride, int width, int height,
+        PixelFormat format, ColorSpace space = Bt601, ColorRange range = LimitedRange, Isa isa = AutoIsa);
+};
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include "qmyuvmosaicview.h"
+#include "qmvideoframe.h"
+#include <QDebug>
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QOpenGLShader>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QOpenGLVertexArrayObject>
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
+
+namespace {
+
+// clang-format off
+
+// 单位矩形，位置在顶点着色器中按各画面的区域变换
+constexpr GLfloat kVertices[] = {
+        // 位置        // 纹理坐标
+        0.0f, 1.0f,  0.0f, 1.0f,  // 左上角
+        0.0f, 0.0f,  0.0f, 0.0f,  // 左下角
+        1.0f, 0.0f,  1.0f, 0.0f,  // 右下角
+        1.0f, 1.0f,  1.0f, 1.0f   // 右上角
+};
+constexpr GLuint kIndices[] = {
+    0, 1, 2,
+    0, 2, 3
+};
+// clang-format on
+
+// 每个实例对应一路画面，gl_InstanceID 即纹理数组的层号
+constexpr std::string_view kVertexShaderCode = R"(
+    #version 330 core
+    layout (location = 0) in vec2 aPos;
+    layout (location = 1) in vec2 aTexCoord;
+    // 画面区域（归一化设备坐标，x, y, w, h）
+    uniform vec4 tile_rects[64];
+    // 画面尺寸（像素）
+    uniform vec2 tile_sizes[64];
+    out vec2 TexCoord;
+    flat out vec2 FrameSize;
+    flat out int Layer;
+    void main() {
+        vec4 rect = tile_rects[gl_InstanceID];
+        gl_Position = vec4(rect.xy + aPos * rect.zw, 0, 1);
+        TexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);
+        FrameSize = tile_sizes[gl_InstanceID];
+        Layer = gl_InstanceID;
+    }
+)";
+
+constexpr std::string_view kFragmentShaderCode = R"(
+    #version 330 core
+    out vec4 FragColor;
+    in vec2 TexCoord;
+    flat in vec2 FrameSize;
+    flat in int Layer;
+    uniform sampler2DArray y_tex;
+    uniform sampler2DArray u_tex;
+    uniform sampler2DArray v_tex;
+    // 画面可能小于纹理层，采样限制在画面区域内，避免线性过滤取到区域外的内容
+    vec3 coord(vec2 frame_size, vec2 layer_size) {
+        vec2 pixel = clamp(TexCoord * frame_size, vec2(0.5), frame_size - 0.5);
+        return vec3(pixel / layer_size, Layer);
+    }
+    void main() {
+        vec2 chroma_size = ceil(FrameSize / 2.0);
+        float y = texture(y_tex, coord(FrameSize, vec2(textureSize(y_tex, 0).xy))).r;
+        float u = texture(u_tex, coord(chroma_size, vec2(textureSize(u_tex, 0).xy))).r - 0.5;
+        float v = texture(v_tex, coord(chroma_size, vec2(textureSize(v_tex, 0).xy))).r - 0.5;
+        float r = y + 1.402 * v;
+        float g = y - 0.344 * u - 0.714 * v;
+        float b = y + 1.772 * u;
+        FragColor = vec4(r, g, b, 1.0);
+    }
+)";
+
+// 奇数宽高时色度平面向上取整
+QSize chromaSize(const QSize& size)
+{
+    return { (size.width() + 1) / 2, (size.height() + 1) / 2 };
+}
+}
+
+class QmYuvMosaicViewPrivate : private QOpenGLFunctions_3_3_Core {
+public:
+    QmYuvMosaicViewPrivate(QmYuvMosaicView* q);
+
+    void init();
+    void paint();
+    void release();
+
+    void setTileRects(const QList<QRectF>& rects);
+    void setTileRect(int tile, const QRectF& rect);
+    QRectF tileRect(int tile) const;
+    int tileCount() const;
+    void setBuffer(int tile, const QByteArray& yuv_buf, const QSize& size);
+    void setFrame(int tile, const QmVideoFrame& frame);
+    void clearTile(int tile);
+    qint64 uploadCount() const;
+
+private:
+    struct Tile {
+        QRectF rect;
+        QSize size;
+        QByteArray yuv_buf;
+        QmVideoFrame frame;
+        // 每次设置新数据时递增，与已上传的代数相同时不再上传
+        quint64 generation { 0 };
+        quint64 uploaded_generation { 0 };
+
+        bool hasData() const { return !yuv_buf.isEmpty() || !frame.isNull(); }
+    };
+
+    void ensureStorage();
+    void uploadTile(int layer, Tile& tile);
+
+    QmYuvMosaicView* q_ { nullptr };
+    QOpenGLShaderProgram* program_ { nullptr };
+    QOpenGLVertexArrayObject* vao_ { nullptr };
+    std::unique_ptr<QOpenGLBuffer> vbo_;
+    std::unique_ptr<QOpenGLBuffer> ebo_;
+    std::unique_ptr<QOpenGLTexture> textures_[3];
+
+    std::vector<Tile> tiles_;
+    // 纹理数组当前的层尺寸与层数
+    QSize layer_size_;
+    int layer_count_ { 0 };
+    qint64 upload_count_ { 0 };
+};
+
+QmYuvMosaicViewPrivate::QmYuvMosaicViewPrivate(QmYuvMosaicView* q)
+    : q_(q)
+    , program_(new QOpenGLShaderProgram(q))
+    , vao_(new QOpenGLVertexArrayObject(q))
+    , vbo_(new QOpenGLBuffer(QOpenGLBuffer::VertexBuffer))
+    , ebo_(new QOpenGLBuffer(QOpenGLBuffer::IndexBuffer))
+{
+    for (auto& texture : textures_) {
+        texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target2DArray);
+    }
+}
+
+void QmYuvMosaicViewPrivate::init()
+{
+    initializeOpenGLFunctions();
+
+    vao_->create();
+    vao_->bind();
+
+    vbo_->create();
+    vbo_->bind();
+    vbo_->setUsagePattern(QOpenGLBuffer::StaticDraw);
+    vbo_->allocate(kVertices, sizeof(kVertices));
+
+    ebo_->create();
+    ebo_->bind();
+    ebo_->setUsagePattern(QOpenGLBuffer::StaticDraw);
+    ebo_->allocate(kIndices, sizeof(kIndices));
+
+    program_->create();
+    program_->addShaderFromSourceCode(QOpenGLShader::Vertex, kVertexShaderCode.data());
+    program_->addShaderFromSourceCode(QOpenGLShader::Fragment, kFragmentShaderCode.data());
+    if (!program_->link()) {
+        qDebug() << "QmYuvMosaicView: shader link failed:" << program_->log();
+    }
+    program_->bind();
+
+    program_->setAttributeArray(0, GL_FLOAT, nullptr, 2, 4 * sizeof(GLfloat));
+    program_->enableAttributeArray(0);
+
+    program_->setAttributeArray(1, GL_FLOAT, (void*)(2 * sizeof(GLfloat)), 2, 4 * sizeof(GLfloat));
+    program_->enableAttributeArray(1);
+
+    // 上下文重建后纹理已失效，首次绘制时重新分配并上传
+    layer_size_ = {};
+    layer_count_ = 0;
+    for (auto& tile : tiles_) {
+        tile.uploaded_generation = 0;
+    }
+}
+
+// 需要当前上下文
+void QmYuvMosaicViewPrivate::release()
+{
+    for (auto& texture : textures_) {
+        if (texture->isCreated()) {
+            texture->destroy();
+        }
+    }
+    layer_size_ = {};
+    layer_count_ = 0;
+}
+
+void QmYuvMosaicViewPrivate::setTileRects(const QList<QRectF>& rects)
+{
+    tiles_.resize(std::min<qsizetype>(rects.size(), QmYuvMosaicView::kMaxTiles));
+    for (size_t i = 0; i < tiles_.size(); ++i) {
+        tiles_[i].rect = rects[i];
+    }
+}
+
+void QmYuvMosaicViewPrivate::setTileRect(int tile, const QRectF& rect)
+{
+    if (tile >= 0 && tile < tileCount()) {
+        tiles_[tile].rect = rect;
+    }
+}
+
+QRectF QmYuvMosaicViewPrivate::tileRect(int tile) const
+{
+    return (tile >= 0 && tile < tileCount()) ? tiles_[tile].rect : QRectF();
+}
+
+int QmYuvMosaicViewPrivate::tileCount() const
+{
+    return static_cast<int>(tiles_.size());
+}
+
+void QmYuvMosaicViewPrivate::setBuffer(int tile, const QByteArray& yuv_buf, const QSize& size)
+{
+    Tile& target = tiles_[tile];
+    target.yuv_buf = yuv_buf;
+    target.frame = {};
+    target.size = size;
+    ++target.generation;
+}
+
+void QmYuvMosaicViewPrivate::setFrame(int tile, const QmVideoFrame& frame)
+{
+    Tile& target = tiles_[tile];
+    target.frame = frame;
+    target.yuv_buf.clear();
+    target.size = frame.size();
+    ++target.generation;
+}
+
+void QmYuvMosaicViewPrivate::clearTile(int tile)
+{
+    Tile& target = tiles_[tile];
+    target.frame = {};
+    target.yuv_buf.clear();
+    target.size = {};
+    ++target.generation;
+}
+
+qint64 QmYuvMosaicViewPrivate::uploadCount() const
+{
+    return upload_count_;
+}
+
+// 各层尺寸相同，取所有画面中的最大尺寸；只在需要变大或画面数变化时重新分配
+void QmYuvMosaicViewPrivate::ensureStorage()
+{
+    QSize needed = layer_size_;
+    for (const auto& tile : tiles_) {
+        needed = needed.expandedTo(tile.size);
+    }
+    const int layer_count = std::max(tileCount(), 1);
+    if (needed.isEmpty() || (needed == layer_size_ && layer_count == layer_count_)) {
+        return;
+    }
+    layer_size_ = needed;
+    layer_count_ = layer_count;
+    for (int plane = 0; plane < 3; ++plane) {
+        QOpenGLTexture* texture = textures_[plane].get();
+        if (texture->isCreated()) {
+            texture->destroy();
+        }
+        const QSize size = plane == 0 ? layer_size_ : chromaSize(layer_size_);
+        texture->create();
+        texture->setFormat(QOpenGLTexture::R8_UNorm);
+        texture->setMinificationFilter(QOpenGLTexture::Linear);
+        texture->setMagnificationFilter(QOpenGLTexture::Linear);
+        texture->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
+        texture->setSize(size.width(), size.height());
+        texture->setLayers(layer_count_);
+        texture->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
+    }
+    // 新的存储内容未定义，全部画面重新上传
+    for (auto& tile : tiles_) {
+        tile.uploaded_generation = 0;
+    }
+}
+
+void QmYuvMosaicViewPrivate::uploadTile(int layer, Tile& tile)
+{
+    const QSize chroma_size = chromaSize(tile.size);
+    const auto* data = reinterpret_cast<const uchar*>(tile.yuv_buf.constData());
+    const int y_size = tile.size.width() * tile.size.height();
+    const int uv_size = chroma_size.width() * chroma_size.height();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int plane = 0; plane < 3; ++plane) {
+        const QSize size = plane == 0 ? tile.size : chroma_size;
+        const uchar* bits = nullptr;
+        int stride = size.width();
+        if (!tile.frame.isNull()) {
+            bits = tile.frame.constBits(plane);
+            stride = tile.frame.bytesPerLine(plane);
+        } else {
+            bits = data + (plane == 0 ? 0 : y_size + (plane - 1) * uv_size);
+        }
+        // 只写入该层中画面所占的区域
+        textures_[plane]->bind();
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size.width(), size.height(), 1, GL_RED, GL_UNSIGNED_BYTE, bits);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    tile.uploaded_generation = tile.generation;
+    ++upload_count_;
+}
+
+void QmYuvMosaicViewPrivate::paint()
+{
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (tiles_.empty()) {
+        return;
+    }
+    ensureStorage();
+    if (layer_count_ == 0) {
+        return;
+    }
+
+    // 画面区域转换为归一化设备坐标，没有数据的画面退化为空区域，不产生片元
+    std::vector<GLfloat> rects(tiles_.size() * 4, 0.0f);
+    std::vector<GLfloat> sizes(tiles_.size() * 2, 1.0f);
+    for (size_t i = 0; i < tiles_.size(); ++i) {
+        Tile& tile = tiles_[i];
+        if (!tile.hasData() || tile.size.isEmpty()) {
+            continue;
+        }
+        if (tile.uploaded_generation != tile.generation) {
+            uploadTile(static_cast<int>(i), tile);
+        }
+        rects[i * 4 + 0] = static_cast<GLfloat>(tile.rect.x() * 2 - 1);
+        rects[i * 4 + 1] = static_cast<GLfloat>(1 - tile.rect.bottom() * 2);
+        rects[i * 4 + 2] = static_cast<GLfloat>(tile.rect.width() * 2);
+        rects[i * 4 + 3] = static_cast<GLfloat>(tile.rect.height() * 2);
+        sizes[i * 2 + 0] = static_cast<GLfloat>(tile.size.width());
+        sizes[i * 2 + 1] = static_cast<GLfloat>(tile.size.height());
+    }
+
+    program_->bind();
+    for (int plane = 0; plane < 3; ++plane) {
+        textures_[plane]->bind(plane);
+    }
+    program_->setUniformValue("y_tex", 0);
+    program_->setUniformValue("u_tex", 1);
+    program_->setUniformValue("v_tex", 2);
+    program_->setUniformValueArray("tile_rects", rects.data(), tileCount(), 4);
+    program_->setUniformValueArray("tile_sizes", sizes.data(), tileCount(), 2);
+
+    vao_->bind();
+    glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, tileCount());
+}
+
+QmYuvMosaicView::QmYuvMosaicView(QWidget* parent)
+    : QOpenGLWidget(parent)
+    , d_(new QmYuvMosaicViewPrivate(this))
+{
+}
+
+QmYuvMosaicView::~QmYuvMosaicView() noexcept
+{
+    if (isValid()) {
+        makeCurrent();
+        d_->release();
+        doneCurrent();
+    }
+    delete d_;
+}
+
+void QmYuvMosaicView::setGrid(int columns, int rows)
+{
+    columns = std::max(columns, 1);
+    rows = std::max(rows, 1);
+    QList<QRectF> rects;
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            rects.append(QRectF(static_cast<qreal>(column) / columns, static_cast<qreal>(row) / rows, 1.0 / columns, 1.0 / rows));
+        }
+    }
+    setTileRects(rects);
+}
+
+void QmYuvMosaicView::setTileRects(const QList<QRectF>& rects)
+{
+    if (rects.size() > kMaxTiles) {
+        qDebug() << "QmYuvMosaicView::setTileRects. too many tiles:" << rects.size() << ", max" << kMaxTiles;
+    }
+    d_->setTileRects(rects);
+    update();
+}
+
+void QmYuvMosaicView::setTileRect(int tile, const QRectF& rect)
+{
+    d_->setTileRect(tile, rect);
+    update();
+}
+
+QRectF QmYuvMosaicView::tileRect(int tile) const
+{
+    return d_->tileRect(tile);
+}
+
+int QmYuvMosaicView::tileCount() const
+{
+    return d_->tileCount();
+}
+
+void QmYuvMosaicView::setData(int tile, const QByteArray& yuv_data, const QSize& yuv_size)
+{
+    const QSize chroma_size = chromaSize(yuv_size);
+    const qsizetype required = static_cast<qsizetype>(yuv_size.width()) * yuv_size.height() + 2 * chroma_size.width() * chroma_size.height();
+    if (tile < 0 || tile >= tileCount() || yuv_size.isEmpty() || yuv_data.size() < required) {
+        qDebug() << "QmYuvMosaicView::setData. invalid tile or data:" << tile << yuv_size << yuv_data.size();
+        return;
+    }
+    d_->setBuffer(tile, yuv_data, yuv_size);
+    update();
+}
+
+void QmYuvMosaicView::setData(int tile, const QmVideoFrame& frame)
+{
+    if (tile < 0 || tile >= tileCount()) {
+        qDebug() << "QmYuvMosaicView::setData. invalid tile:" << tile;
+        return;
+    }
+    // yuvj420p 与 yuv420p 内存布局相同
+    if (frame.isNull() || (frame.pixelFormat() != AV_PIX_FMT_YUV420P && frame.pixelFormat() != AV_PIX_FMT_YUVJ420P)) {
+        qDebug() << "QmYuvMosaicView::setData. unsupported frame format:" << frame.pixelFormat();
+        return;
+    }
+    d_->setFrame(tile, frame);
+    update();
+}
+
+void QmYuvMosaicView::clearTile(int tile)
+{
+    if (tile < 0 || tile >= tileCount()) {
+        return;
+    }
+    d_->clearTile(tile);
+    update();
+}
+
+qint64 QmYuvMosaicView::uploadCount() const
+{
+    return d_->uploadCount();
+}
+
+void QmYuvMosaicView::initializeGL()
+{
+    d_->init();
+}
+
+void QmYuvMosaicView::resizeGL(int w, int h)
+{
+}
+
+void QmYuvMosaicView::paintGL()
+{
+    d_->paint();
+}
\ No newline at end of file
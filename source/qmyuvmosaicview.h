@@ -0,0 +1,46 @@
+#pragma once
+
+#include "qmvideo_global.h"
+#include <QList>
+#include <QOpenGLWidget>
+#include <QRectF>
+
+class QmYuvMosaicViewPrivate;
+class QmVideoFrame;
+
+// 在一个控件中绘制多路 yuv420p 画面
+// 所有画面共用一个上下文与着色器，各路画面存放在纹理数组的不同层中，一次实例化绘制完成，只上传有新帧的画面
+class QMVIDEO_LIB_EXPORT QmYuvMosaicView : public QOpenGLWidget {
+    Q_OBJECT
+public:
+    // 纹理数组层数上限，与着色器中的数组长度一致
+    static constexpr int kMaxTiles = 64;
+
+    explicit QmYuvMosaicView(QWidget* parent = nullptr);
+    ~QmYuvMosaicView() noexcept override;
+
+    // 按 columns x rows 均分控件，画面数为 columns * rows
+    void setGrid(int columns, int rows);
+    // 自定义布局，rect 为相对控件的归一化坐标（左上角为 (0, 0)，右下角为 (1, 1)），画面数为 rects.size()
+    void setTileRects(const QList<QRectF>& rects);
+    void setTileRect(int tile, const QRectF& rect);
+    QRectF tileRect(int tile) const;
+    int tileCount() const;
+
+    // 紧密排列的 yuv420p
+    void setData(int tile, const QByteArray& yuv_data, const QSize& yuv_size);
+    // yuv420p 平面帧，按各平面的 linesize 上传
+    void setData(int tile, const QmVideoFrame& frame);
+    void clearTile(int tile);
+
+    // 画面上传的次数，只计有新帧的画面
+    qint64 uploadCount() const;
+
+protected:
+    void initializeGL() override;
+    void resizeGL(int w, int h) override;
+    void paintGL() override;
+
+private:
+    QmYuvMosaicViewPrivate* d_ { nullptr };
+};
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "qmyuvview.h"
 #include "qmvideodecoder.h"
+#include "qmvideoframe.h"
 #include <QFile>
 #include <QKeyEvent>
 #include <QOpenGLBuffer>
+#include <QOpenGLContext>
 #include <QOpenGLFunctions_3_3_Core>
 #include <QOpenGLPixelTransferOptions>
 #include <QOpenGLShader>
@@ -10,6 +12,11 @@
 #include <QOpenGLTexture>
 #include <QOpenGLVertexArrayObject>
 #include <QTimer>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/pixfmt.h>
+}
 
 namespace {
 
@@ -48,11 +55,16 @@ constexpr std::string_view kFragmentShaderCode = R"(
     uniform sampler2D y_tex;
     uniform sampler2D u_tex;
     uniform sampler2D v_tex;
+    // 色度交织在 u_tex 的 rg 分量中
+    uniform bool semi_planar;
+    // 采样值到 [0, 1] 的缩放
+    uniform float scale;
     void main() {
         // YUV数据转换为RGB数据
-        float y = texture(y_tex, TexCoord).r;
-        float u = texture(u_tex, TexCoord).r - 0.5;
-        float v = texture(v_tex, TexCoord).r - 0.5;
+        float y = texture(y_tex, TexCoord).r * scale;
+        vec2 uv = semi_planar ? texture(u_tex, TexCoord).rg : vec2(texture(u_tex, TexCoord).r, texture(v_tex, TexCoord).r);
+        float u = uv.x * scale - 0.5;
+        float v = uv.y * scale - 0.5;
         float r = y + 1.402 * v;
         float g = y - 0.344 * u - 0.714 * v;
         float b = y + 1.772 * u;
@@ -60,7 +72,60 @@ constexpr std::string_view kFragmentShaderCode = R"(
     }
 )";
 
-GLuint tex_y, tex_u, tex_v;
+// 像素缓冲区个数，GPU 读取上一帧的同时写入下一帧
+constexpr int kPixelBufferCount = 3;
+// 各平面在像素缓冲区中的起始偏移对齐
+constexpr GLsizeiptr kPlaneAlignment = 64;
+// 持久映射时等待 GPU 读完缓冲区的最长时间
+constexpr GLuint64 kFenceTimeoutNs = 100'000'000;
+
+using BufferStorageFunc = void(QOPENGLF_APIENTRYP)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+// 奇数宽高时色度平面向上取整
+QSize chromaSize(const QSize& size)
+{
+    return { (size.width() + 1) / 2, (size.height() + 1) / 2 };
+}
+
+struct PlaneFormat {
+    QOpenGLTexture::TextureFormat texture_format;
+    QOpenGLTexture::PixelFormat pixel_format;
+    QOpenGLTexture::PixelType pixel_type;
+    GLenum gl_format;
+    GLenum gl_type;
+    // 每个纹素的字节数
+    int pixel_size;
+};
+
+struct InputLayout {
+    int plane_count;
+    PlaneFormat planes[3];
+    bool semi_planar;
+    float scale;
+};
+
+constexpr PlaneFormat kR8 { QOpenGLTexture::R8_UNorm, QOpenGLTexture::Red, QOpenGLTexture::UInt8, GL_RED, GL_UNSIGNED_BYTE, 1 };
+constexpr PlaneFormat kRG8 { QOpenGLTexture::RG8_UNorm, QOpenGLTexture::RG, QOpenGLTexture::UInt8, GL_RG, GL_UNSIGNED_BYTE, 2 };
+constexpr PlaneFormat kR16 { QOpenGLTexture::R16_UNorm, QOpenGLTexture::Red, QOpenGLTexture::UInt16, GL_RED, GL_UNSIGNED_SHORT, 2 };
+constexpr PlaneFormat kRG16 { QOpenGLTexture::RG16_UNorm, QOpenGLTexture::RG, QOpenGLTexture::UInt16, GL_RG, GL_UNSIGNED_SHORT, 4 };
+
+const InputLayout& layoutOf(QmYuvView::InputFormat format)
+{
+    // 与 QmYuvView::InputFormat 的顺序一致
+    // yuv420p10 的数据在低 10 位，需放大到 [0, 1]；p010 在高 10 位，归一化后即可直接使用
+    static const InputLayout layouts[] = {
+        { 3, { kR8, kR8, kR8 }, false, 1.0f },
+        { 2, { kR8, kRG8 }, true, 1.0f },
+        { 3, { kR16, kR16, kR16 }, false, 65535.0f / 1023.0f },
+        { 2, { kR16, kRG16 }, true, 1.0f },
+    };
+    return layouts[format];
+}
+
+QSize planeSize(const QSize& size, int plane)
+{
+    return plane == 0 ? size : chromaSize(size);
+}
 }
 
 class QmYuvViewPrivate : private QOpenGLFunctions_3_3_Core {
@@ -71,10 +136,44 @@ public:
     void init();
     void paint();
 
-    void setSize(const QSize& yuv_size);
-    void setBuffer(const QByteArray& yuv_buf);
+    void setLayout(QmYuvView::InputFormat format, const QSize& yuv_size);
+    void setBuffer(const QByteArray& yuv_buf, const QList<int>& linesizes);
+    void setFrame(const QmVideoFrame& frame);
+
+    void setUploadMode(QmYuvView::UploadMode mode);
+    QmYuvView::UploadMode uploadMode() const;
+    qint64 uploadCount() const;
+    void releaseBuffers();
 
 private:
+    struct Plane {
+        const uchar* data { nullptr };
+        int stride { 0 };
+        int width { 0 };
+        int height { 0 };
+        int pixel_size { 1 };
+
+        // 最后一行只计可见宽度，不读取行尾之后的内存
+        GLsizeiptr bytes() const { return height > 0 ? static_cast<GLsizeiptr>(stride) * (height - 1) + width * pixel_size : 0; }
+    };
+
+    struct PixelBuffer {
+        GLuint id { 0 };
+        GLsizeiptr size { 0 };
+        // 持久映射的地址
+        void* mapped { nullptr };
+        // 最近一次从该缓冲区上传纹理的命令
+        GLsync fence { nullptr };
+    };
+
+    void allocateTextures();
+    void planes(Plane out[3]) const;
+    void upload();
+    bool uploadBuffered(const Plane planes[3]);
+    uchar* mapBuffer(PixelBuffer& buffer, GLsizeiptr size);
+    void releaseBuffer(PixelBuffer& buffer);
+    void updateUploadMode();
+
     QmYuvView* q_ { nullptr };
     QOpenGLShaderProgram* program_ { nullptr };
     QOpenGLVertexArrayObject* vao_ { nullptr };
@@ -86,7 +185,21 @@ private:
     std::unique_ptr<QOpenGLTexture> tex_v_;
 
     QSize yuv_size_ { 1254, 940 };
+    QmYuvView::InputFormat input_format_ { QmYuvView::Yuv420p };
     QByteArray yuv_buf_;
+    // yuv_buf_ 中各平面的行字节数
+    QList<int> linesizes_;
+    QmVideoFrame frame_;
+
+    QmYuvView::UploadMode requested_mode_ { QmYuvView::PersistentUpload };
+    QmYuvView::UploadMode upload_mode_ { QmYuvView::PersistentUpload };
+    BufferStorageFunc buffer_storage_ { nullptr };
+    PixelBuffer pixel_buffers_[kPixelBufferCount];
+    int next_buffer_ { 0 };
+    // 每次设置新数据时递增，与已上传的代数相同时重绘不再上传
+    quint64 generation_ { 0 };
+    quint64 uploaded_generation_ { 0 };
+    qint64 upload_count_ { 0 };
 };
 
 QmYuvViewPrivate::QmYuvViewPrivate(QmYuvView* q)
@@ -135,84 +248,253 @@ void QmYuvViewPrivate::init()
     program_->enableAttributeArray(1);
 
     // 在OpenGL上下文中初始化纹理
-    tex_y_->create();
-    tex_y_->setFormat(QOpenGLTexture::R8_UNorm);
-    tex_y_->setMinificationFilter(QOpenGLTexture::Linear);
-    tex_y_->setMagnificationFilter(QOpenGLTexture::Linear);
-    tex_y_->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
-    tex_y_->setSize(yuv_size_.width(), yuv_size_.height());
-    tex_y_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
-
-    tex_u_->create();
-    tex_u_->setFormat(QOpenGLTexture::R8_UNorm);
-    tex_u_->setMinificationFilter(QOpenGLTexture::Linear);
-    tex_u_->setMagnificationFilter(QOpenGLTexture::Linear);
-    tex_u_->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
-    tex_u_->setSize(yuv_size_.width() / 2, yuv_size_.height() / 2);
-    tex_u_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
-
-    tex_v_->create();
-    tex_v_->setFormat(QOpenGLTexture::R8_UNorm);
-    tex_v_->setMinificationFilter(QOpenGLTexture::Linear);
-    tex_v_->setMagnificationFilter(QOpenGLTexture::Linear);
-    tex_v_->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
-    tex_v_->setSize(yuv_size_.width() / 2, yuv_size_.height() / 2);
-    tex_v_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
-}
-
-void QmYuvViewPrivate::setSize(const QSize& size)
-{
-    if (yuv_size_ == size) {
+    allocateTextures();
+
+    // 上下文重建后旧的缓冲区与纹理已失效
+    for (auto& buffer : pixel_buffers_) {
+        buffer = {};
+    }
+    uploaded_generation_ = 0;
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    buffer_storage_ = nullptr;
+    if (ctx && !ctx->isOpenGLES() && (ctx->format().version() >= qMakePair(4, 4) || ctx->hasExtension("GL_ARB_buffer_storage"))) {
+        buffer_storage_ = reinterpret_cast<BufferStorageFunc>(ctx->getProcAddress("glBufferStorage"));
+    }
+    updateUploadMode();
+}
+
+void QmYuvViewPrivate::updateUploadMode()
+{
+    upload_mode_ = requested_mode_;
+    if (upload_mode_ == QmYuvView::PersistentUpload && !buffer_storage_) {
+        upload_mode_ = QmYuvView::BufferedUpload;
+    }
+}
+
+void QmYuvViewPrivate::setUploadMode(QmYuvView::UploadMode mode)
+{
+    if (requested_mode_ == mode) {
+        return;
+    }
+    requested_mode_ = mode;
+    if (!q_->isValid()) {
+        upload_mode_ = mode;
         return;
     }
-    yuv_size_ = size;
     q_->makeCurrent();
-    // 在OpenGL上下文中初始化纹理
-    if (tex_y_->isStorageAllocated()) {
-        tex_y_->destroy();
-        tex_y_->create();
-        tex_y_->setFormat(QOpenGLTexture::R8_UNorm);
-        tex_y_->setMinificationFilter(QOpenGLTexture::Linear);
-        tex_y_->setMagnificationFilter(QOpenGLTexture::Linear);
-        tex_y_->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
-        tex_y_->setSize(size.width(), size.height());
-        tex_y_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
-    } else {
-        tex_y_->setSize(size.width(), size.height());
-        tex_y_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
+    releaseBuffers();
+    updateUploadMode();
+    q_->doneCurrent();
+}
+
+QmYuvView::UploadMode QmYuvViewPrivate::uploadMode() const
+{
+    return upload_mode_;
+}
+
+qint64 QmYuvViewPrivate::uploadCount() const
+{
+    return upload_count_;
+}
+
+void QmYuvViewPrivate::releaseBuffer(PixelBuffer& buffer)
+{
+    if (buffer.fence) {
+        glDeleteSync(buffer.fence);
     }
-    if (tex_u_->isStorageAllocated()) {
-        tex_u_->destroy();
-        tex_u_->create();
-        tex_u_->setFormat(QOpenGLTexture::R8_UNorm);
-        tex_u_->setMinificationFilter(QOpenGLTexture::Linear);
-        tex_u_->setMagnificationFilter(QOpenGLTexture::Linear);
-        tex_u_->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
-        tex_u_->setSize(size.width() / 2, size.height() / 2);
-        tex_u_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
-    } else {
-        tex_u_->setSize(size.width() / 2, size.height() / 2);
-        tex_u_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
+    if (buffer.id) {
+        if (buffer.mapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer.id);
     }
-    if (tex_v_->isStorageAllocated()) {
-        tex_v_->destroy();
-        tex_v_->create();
-        tex_v_->setFormat(QOpenGLTexture::R8_UNorm);
-        tex_v_->setMinificationFilter(QOpenGLTexture::Linear);
-        tex_v_->setMagnificationFilter(QOpenGLTexture::Linear);
-        tex_v_->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
-        tex_v_->setSize(size.width() / 2, size.height() / 2);
-        tex_v_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
-    } else {
-        tex_v_->setSize(size.width() / 2, size.height() / 2);
-        tex_v_->allocateStorage(QOpenGLTexture::Red, QOpenGLTexture::UInt8);
+    buffer = {};
+}
+
+// 需要当前上下文
+void QmYuvViewPrivate::releaseBuffers()
+{
+    for (auto& buffer : pixel_buffers_) {
+        releaseBuffer(buffer);
+    }
+    next_buffer_ = 0;
+}
+
+// 纹理存储不可变，只在格式或尺寸变化时重新创建
+void QmYuvViewPrivate::allocateTextures()
+{
+    const InputLayout& layout = layoutOf(input_format_);
+    QOpenGLTexture* textures[] = { tex_y_.get(), tex_u_.get(), tex_v_.get() };
+    for (int plane = 0; plane < 3; ++plane) {
+        QOpenGLTexture* texture = textures[plane];
+        if (texture->isCreated()) {
+            texture->destroy();
+        }
+        if (plane >= layout.plane_count) {
+            continue;
+        }
+        const QSize size = planeSize(yuv_size_, plane);
+        texture->create();
+        texture->setFormat(layout.planes[plane].texture_format);
+        texture->setMinificationFilter(QOpenGLTexture::Linear);
+        texture->setMagnificationFilter(QOpenGLTexture::Linear);
+        texture->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
+        texture->setSize(size.width(), size.height());
+        texture->allocateStorage(layout.planes[plane].pixel_format, layout.planes[plane].pixel_type);
+    }
+}
+
+void QmYuvViewPrivate::setLayout(QmYuvView::InputFormat format, const QSize& size)
+{
+    if (input_format_ == format && yuv_size_ == size) {
+        return;
+    }
+    input_format_ = format;
+    yuv_size_ = size;
+    // 尚未初始化时由 init() 分配
+    if (!q_->isValid()) {
+        return;
     }
+    q_->makeCurrent();
+    allocateTextures();
     q_->doneCurrent();
 }
 
-void QmYuvViewPrivate::setBuffer(const QByteArray& yuv_buf)
+void QmYuvViewPrivate::setBuffer(const QByteArray& yuv_buf, const QList<int>& linesizes)
 {
     yuv_buf_ = yuv_buf;
+    linesizes_ = linesizes;
+    frame_ = {};
+    ++generation_;
+}
+
+void QmYuvViewPrivate::setFrame(const QmVideoFrame& frame)
+{
+    frame_ = frame;
+    yuv_buf_.clear();
+    linesizes_.clear();
+    ++generation_;
+}
+
+void QmYuvViewPrivate::planes(Plane out[3]) const
+{
+    const InputLayout& layout = layoutOf(input_format_);
+    const auto* data = reinterpret_cast<const uchar*>(yuv_buf_.constData());
+    qsizetype offset = 0;
+    for (int plane = 0; plane < layout.plane_count; ++plane) {
+        const QSize size = planeSize(yuv_size_, plane);
+        const int pixel_size = layout.planes[plane].pixel_size;
+        if (!frame_.isNull()) {
+            out[plane] = { frame_.constBits(plane), frame_.bytesPerLine(plane), size.width(), size.height(), pixel_size };
+            continue;
+        }
+        // 各平面在缓冲区中依次存放
+        const int stride = plane < linesizes_.size() ? linesizes_[plane] : size.width() * pixel_size;
+        out[plane] = { data + offset, stride, size.width(), size.height(), pixel_size };
+        offset += static_cast<qsizetype>(stride) * size.height();
+    }
+}
+
+uchar* QmYuvViewPrivate::mapBuffer(PixelBuffer& buffer, GLsizeiptr size)
+{
+    if (upload_mode_ == QmYuvView::PersistentUpload) {
+        if (buffer.size < size) {
+            // 不可变存储无法调整大小，重新创建
+            releaseBuffer(buffer);
+            glGenBuffers(1, &buffer.id);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            buffer_storage_(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+            buffer.mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+            buffer.size = buffer.mapped ? size : 0;
+        } else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+        }
+        if (buffer.fence) {
+            // GPU 仍在读取时不能写入，本帧改为直接上传，保留 fence 供下次复用时再等待
+            const GLenum result = glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+            if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED) {
+                return nullptr;
+            }
+            glDeleteSync(buffer.fence);
+            buffer.fence = nullptr;
+        }
+        return static_cast<uchar*>(buffer.mapped);
+    }
+
+    if (!buffer.id) {
+        glGenBuffers(1, &buffer.id);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer.id);
+    // 重新指定存储，GPU 仍在读取的旧存储由驱动回收，映射时无需等待
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    buffer.size = size;
+    return static_cast<uchar*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+}
+
+bool QmYuvViewPrivate::uploadBuffered(const Plane planes[3])
+{
+    const InputLayout& layout = layoutOf(input_format_);
+    GLsizeiptr offsets[3] {};
+    GLsizeiptr total = 0;
+    for (int plane = 0; plane < layout.plane_count; ++plane) {
+        offsets[plane] = total;
+        total += (planes[plane].bytes() + kPlaneAlignment - 1) / kPlaneAlignment * kPlaneAlignment;
+    }
+
+    PixelBuffer& buffer = pixel_buffers_[next_buffer_];
+    next_buffer_ = (next_buffer_ + 1) % kPixelBufferCount;
+    uchar* dst = mapBuffer(buffer, total);
+    if (!dst) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    for (int plane = 0; plane < layout.plane_count; ++plane) {
+        memcpy(dst + offsets[plane], planes[plane].data, planes[plane].bytes());
+    }
+    if (!buffer.mapped) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    // 绑定像素缓冲区时 glTexSubImage2D 的数据指针为缓冲区内的偏移
+    QOpenGLTexture* textures[] = { tex_y_.get(), tex_u_.get(), tex_v_.get() };
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int plane = 0; plane < layout.plane_count; ++plane) {
+        // GL_UNPACK_ROW_LENGTH 以纹素为单位
+        const PlaneFormat& format = layout.planes[plane];
+        textures[plane]->bind();
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, planes[plane].stride / format.pixel_size);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, planes[plane].width, planes[plane].height, format.gl_format, format.gl_type,
+            reinterpret_cast<const void*>(offsets[plane]));
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    if (buffer.mapped) {
+        buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
+
+void QmYuvViewPrivate::upload()
+{
+    Plane src[3];
+    planes(src);
+    if (upload_mode_ == QmYuvView::DirectUpload || !uploadBuffered(src)) {
+        // 通过 GL_UNPACK_ROW_LENGTH 跳过每行末尾的对齐填充
+        const InputLayout& layout = layoutOf(input_format_);
+        QOpenGLTexture* textures[] = { tex_y_.get(), tex_u_.get(), tex_v_.get() };
+        QOpenGLPixelTransferOptions options;
+        options.setAlignment(1);
+        for (int plane = 0; plane < layout.plane_count; ++plane) {
+            const PlaneFormat& format = layout.planes[plane];
+            options.setRowLength(src[plane].stride / format.pixel_size);
+            textures[plane]->setData(format.pixel_format, format.pixel_type, src[plane].data, &options);
+        }
+    }
+    uploaded_generation_ = generation_;
+    ++upload_count_;
 }
 
 void QmYuvViewPrivate::paint()
@@ -220,25 +502,28 @@ void QmYuvViewPrivate::paint()
     glClear(GL_COLOR_BUFFER_BIT);
 
     // 检查是否有有效的YUV数据
-    if (yuv_buf_.isEmpty()) {
+    if (yuv_buf_.isEmpty() && frame_.isNull()) {
         return; // 没有有效数据时不渲染
     }
 
     program_->bind();
 
-    QOpenGLPixelTransferOptions options;
-    options.setAlignment(1);
-    tex_y_->setData(QOpenGLTexture::Red, QOpenGLTexture::UInt8, yuv_buf_.constData(), &options);
-    tex_u_->setData(QOpenGLTexture::Red, QOpenGLTexture::UInt8, yuv_buf_.constData() + yuv_size_.width() * yuv_size_.height(), &options);
-    tex_v_->setData(QOpenGLTexture::Red, QOpenGLTexture::UInt8, yuv_buf_.constData() + yuv_size_.width() * yuv_size_.height() * 5 / 4, &options);
+    // 只在有新数据时上传，其余重绘复用纹理中的内容
+    if (uploaded_generation_ != generation_) {
+        upload();
+    }
 
-    tex_y_->bind(0);
-    tex_u_->bind(1);
-    tex_v_->bind(2);
+    const InputLayout& layout = layoutOf(input_format_);
+    QOpenGLTexture* textures[] = { tex_y_.get(), tex_u_.get(), tex_v_.get() };
+    for (int plane = 0; plane < layout.plane_count; ++plane) {
+        textures[plane]->bind(plane);
+    }
 
     program_->setUniformValue("y_tex", 0);
     program_->setUniformValue("u_tex", 1);
     program_->setUniformValue("v_tex", 2);
+    program_->setUniformValue("semi_planar", layout.semi_planar);
+    program_->setUniformValue("scale", layout.scale);
 
     vao_->bind();
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
@@ -252,9 +537,30 @@ QmYuvView::QmYuvView(QWidget* parent)
 
 QmYuvView::~QmYuvView() noexcept
 {
+    if (isValid()) {
+        makeCurrent();
+        d_->releaseBuffers();
+        doneCurrent();
+    }
     delete d_;
 }
 
+void QmYuvView::setUploadMode(UploadMode mode)
+{
+    d_->setUploadMode(mode);
+    update();
+}
+
+QmYuvView::UploadMode QmYuvView::uploadMode() const
+{
+    return d_->uploadMode();
+}
+
+qint64 QmYuvView::uploadCount() const
+{
+    return d_->uploadCount();
+}
+
 void QmYuvView::initializeGL()
 {
     d_->init();
@@ -271,7 +577,60 @@ void QmYuvView::paintGL()
 
 void QmYuvView::setData(const QByteArray& yuv_data, const QSize& yuv_size)
 {
-    d_->setBuffer(yuv_data);
-    d_->setSize(yuv_size);
+    setData(yuv_data, yuv_size, Yuv420p);
+}
+
+void QmYuvView::setData(const QByteArray& yuv_data, const QSize& yuv_size, InputFormat format, const QList<int>& linesizes)
+{
+    const InputLayout& layout = layoutOf(format);
+    if (!linesizes.isEmpty() && linesizes.size() != layout.plane_count) {
+        qDebug() << "QmYuvView::setData. expected" << layout.plane_count << "linesizes, got" << linesizes.size();
+        return;
+    }
+    qsizetype required = 0;
+    for (int plane = 0; plane < layout.plane_count; ++plane) {
+        const QSize size = planeSize(yuv_size, plane);
+        const int row_bytes = size.width() * layout.planes[plane].pixel_size;
+        const int stride = linesizes.isEmpty() ? row_bytes : linesizes[plane];
+        // GL_UNPACK_ROW_LENGTH 以纹素为单位，行字节数需为纹素大小的整数倍
+        if (stride < row_bytes || stride % layout.planes[plane].pixel_size != 0) {
+            qDebug() << "QmYuvView::setData. invalid linesize" << stride << "for plane" << plane;
+            return;
+        }
+        required += static_cast<qsizetype>(stride) * size.height();
+    }
+    if (yuv_data.size() < required) {
+        qDebug() << "QmYuvView::setData. buffer too small:" << yuv_data.size() << "<" << required;
+        return;
+    }
+    d_->setBuffer(yuv_data, linesizes);
+    d_->setLayout(format, yuv_size);
+    update();
+}
+
+void QmYuvView::setData(const QmVideoFrame& frame)
+{
+    InputFormat format = Yuv420p;
+    switch (frame.isNull() ? AV_PIX_FMT_NONE : frame.pixelFormat()) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+        // yuvj420p 与 yuv420p 内存布局相同
+        format = Yuv420p;
+        break;
+    case AV_PIX_FMT_NV12:
+        format = Nv12;
+        break;
+    case AV_PIX_FMT_YUV420P10LE:
+        format = Yuv420p10;
+        break;
+    case AV_PIX_FMT_P010LE:
+        format = P010;
+        break;
+    default:
+        qDebug() << "QmYuvView::setData. unsupported frame format:" << frame.pixelFormat();
+        return;
+    }
+    d_->setFrame(frame);
+    d_->setLayout(format, frame.size());
     update();
 }
\ No newline at end of file
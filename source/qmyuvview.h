@@ -1,17 +1,52 @@
 #pragma once
 
 #include "qmvideo_global.h"
+#include <QList>
 #include <QOpenGLWidget>
 
 class QmYuvViewPrivate;
+class QmVideoFrame;
 
 class QMVIDEO_LIB_EXPORT QmYuvView : public QOpenGLWidget {
     Q_OBJECT
 public:
+    // 纹理上传方式
+    enum UploadMode {
+        // QOpenGLTexture::setData 同步上传
+        DirectUpload,
+        // 多个像素缓冲区轮转，每帧重新指定存储后映射写入，由驱动异步传输到纹理
+        BufferedUpload,
+        // 持久映射的像素缓冲区，写入前等待 GPU 读完该缓冲区；需要 GL 4.4 或 GL_ARB_buffer_storage，否则退回到 BufferedUpload
+        PersistentUpload,
+    };
+
+    // 输入的像素格式，各平面的行宽可以大于可见宽度
+    enum InputFormat {
+        // 三个 8 位平面
+        Yuv420p,
+        // 8 位亮度平面与交织的 UV 平面
+        Nv12,
+        // 三个 16 位小端平面，数据在低 10 位
+        Yuv420p10,
+        // 16 位小端亮度平面与交织的 UV 平面，数据在高 10 位
+        P010,
+    };
+
     explicit QmYuvView(QWidget* parent = nullptr);
     ~QmYuvView() noexcept override;
 
+    void setUploadMode(UploadMode mode);
+    // 实际使用的上传方式，initializeGL 之前返回设置的方式
+    UploadMode uploadMode() const;
+    // 纹理上传的次数，没有新帧的重绘不会上传
+    qint64 uploadCount() const;
+
+    // 紧密排列的 yuv420p
     void setData(const QByteArray& yuv_data, const QSize& yuv_size);
+    // 各平面在 yuv_data 中依次存放，linesizes 为各平面的行字节数，为空时按紧密排列计算
+    void setData(const QByteArray& yuv_data, const QSize& yuv_size, InputFormat format, const QList<int>& linesizes = {});
+    // yuv420p / nv12 / yuv420p10le / p010le 帧，按各平面的 linesize 直接上传，不在 CPU 端重新打包
+    void setData(const QmVideoFrame& frame);
 
 protected:
     void initializeGL() override;
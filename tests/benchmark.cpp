@@ -0,0 +1,196 @@
+#include "qmvideoclock.h"
+#include "qmvideodecoder.h"
+#include "qmvideoframe.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QList>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <thread>
+
+namespace {
+const char* modeName(QmVideoDecoder::ThreadingMode mode)
+{
+    switch (mode) {
+    case QmVideoDecoder::FrameThreading:
+        return "frame";
+    case QmVideoDecoder::SliceThreading:
+        return "slice";
+    case QmVideoDecoder::NoThreading:
+        return "none";
+    default:
+        return "auto";
+    }
+}
+
+void benchThreading(QTextStream& out, const QString& video_path, qint64 frame_limit)
+{
+    QList<int> thread_counts { 1 };
+    const int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int n = 2; n < max_threads; n *= 2) {
+        thread_counts.append(n);
+    }
+    if (max_threads > 1) {
+        thread_counts.append(max_threads);
+    }
+
+    double baseline_fps = 0;
+    out << "threading: mode(effective)  threads  frames  fps  speedup\n";
+    for (auto mode : { QmVideoDecoder::FrameThreading, QmVideoDecoder::SliceThreading }) {
+        for (int thread_count : thread_counts) {
+            QmVideoDecoder decoder;
+            decoder.setThreading(mode, thread_count);
+            if (!decoder.open(video_path)) {
+                out << "failed to open " << video_path << "\n";
+                return;
+            }
+            qint64 frames = 0;
+            QElapsedTimer timer;
+            timer.start();
+            while (frames < frame_limit && decoder.readNextFrame().isValid()) {
+                ++frames;
+            }
+            const double fps = frames * 1000.0 / std::max<qint64>(timer.elapsed(), 1);
+            if (baseline_fps == 0) {
+                baseline_fps = fps;
+            }
+            out << "  " << modeName(mode) << "(" << modeName(decoder.threadingMode()) << ")  "
+                << decoder.threadCount() << "  " << frames << "  "
+                << QString::number(fps, 'f', 1) << "  "
+                << QString::number(fps / baseline_fps, 'f', 2) << "x\n";
+            out.flush();
+        }
+    }
+}
+
+struct DeliveryResult {
+    qint64 frames { 0 };
+    double fps { 0 };
+    // 收到帧时呈现时钟超过帧 pts 的时间（us），只在实时模式下统计
+    double mean_latency_us { 0 };
+    double max_latency_us { 0 };
+};
+
+// 消费者在主线程的事件循环中通过 frameReady 接收
+DeliveryResult runSignalDelivery(const QString& video_path, qint64 frame_limit, bool realtime)
+{
+    DeliveryResult result;
+    QmVideoDecoder decoder;
+    decoder.setOutputFormat(QmVideoDecoder::Frame);
+    decoder.setRealtime(realtime);
+    decoder.setDeliveryPolicy(QmVideoDecoder::BlockDelivery, 8);
+    if (!decoder.open(video_path)) {
+        return result;
+    }
+
+    QEventLoop loop;
+    double latency_sum = 0;
+    QObject::connect(&decoder, &QmVideoDecoder::frameReady, &loop, [&](const QVariant& data) {
+        const QmVideoFrame frame = data.value<QmVideoFrame>();
+        const double latency = static_cast<double>(decoder.clock()->time() - frame.timestamp());
+        latency_sum += latency;
+        result.max_latency_us = std::max(result.max_latency_us, latency);
+        if (++result.frames >= frame_limit) {
+            loop.quit();
+        }
+    }, Qt::QueuedConnection);
+    QTimer end_timer;
+    QObject::connect(&end_timer, &QTimer::timeout, &loop, [&] {
+        if (decoder.isWaiting()) {
+            loop.quit();
+        }
+    });
+    end_timer.start(10);
+
+    QElapsedTimer timer;
+    timer.start();
+    decoder.play();
+    loop.exec();
+    result.fps = result.frames * 1000.0 / std::max<qint64>(timer.elapsed(), 1);
+    result.mean_latency_us = result.frames > 0 ? latency_sum / result.frames : 0;
+    decoder.stop();
+    return result;
+}
+
+// 消费者线程轮询环形缓冲区
+DeliveryResult runPullDelivery(const QString& video_path, qint64 frame_limit, bool realtime)
+{
+    DeliveryResult result;
+    QmVideoDecoder decoder;
+    decoder.setOutputFormat(QmVideoDecoder::Frame);
+    decoder.setRealtime(realtime);
+    decoder.setPullMode(true, 8);
+    if (!decoder.open(video_path)) {
+        return result;
+    }
+
+    double latency_sum = 0;
+    QElapsedTimer timer;
+    timer.start();
+    decoder.play();
+    std::thread consumer([&] {
+        QmVideoFrame frame;
+        while (result.frames < frame_limit) {
+            if (!decoder.pullFrame(&frame, 100)) {
+                if (decoder.isWaiting()) {
+                    break;
+                }
+                continue;
+            }
+            const double latency = static_cast<double>(decoder.clock()->time() - frame.timestamp());
+            latency_sum += latency;
+            result.max_latency_us = std::max(result.max_latency_us, latency);
+            ++result.frames;
+        }
+    });
+    consumer.join();
+    result.fps = result.frames * 1000.0 / std::max<qint64>(timer.elapsed(), 1);
+    result.mean_latency_us = result.frames > 0 ? latency_sum / result.frames : 0;
+    decoder.stop();
+    return result;
+}
+
+// 非实时模式比较吞吐量，实时模式比较从呈现时刻到消费者收到帧的延迟
+void benchDelivery(QTextStream& out, const QString& video_path, qint64 frame_limit)
+{
+    out << "delivery: path  mode  frames  fps  mean_latency(us)  max_latency(us)\n";
+    for (bool realtime : { false, true }) {
+        // 实时模式按帧率播放，限制帧数以控制耗时
+        const qint64 limit = realtime ? std::min<qint64>(frame_limit, 300) : frame_limit;
+        const DeliveryResult signal_result = runSignalDelivery(video_path, limit, realtime);
+        const DeliveryResult pull_result = runPullDelivery(video_path, limit, realtime);
+        for (const auto& [name, result] : { std::pair { "signal", signal_result }, std::pair { "pull", pull_result } }) {
+            out << "  " << name << "  " << (realtime ? "realtime" : "unpaced") << "  " << result.frames << "  "
+                << QString::number(result.fps, 'f', 1);
+            if (realtime) {
+                out << "  " << QString::number(result.mean_latency_us, 'f', 0) << "  " << QString::number(result.max_latency_us, 'f', 0);
+            } else {
+                out << "  -  -";
+            }
+            out << "\n";
+            out.flush();
+        }
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList args = app.arguments();
+    if (args.size() < 2) {
+        out << "usage: " << args.value(0) << " <video> [frame_limit]\n";
+        return 1;
+    }
+    const QString video_path = args.at(1);
+    const qint64 frame_limit = args.size() > 2 ? args.at(2).toLongLong() : 600;
+
+    benchThreading(out, video_path, frame_limit);
+    benchDelivery(out, video_path, frame_limit);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "qmdeliverytracker.h"
+#include "qmframepool.h"
+#include "qmvideoframe.h"
+#include <QCoreApplication>
+#include <QImage>
+#include <QTextStream>
+#include <functional>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace {
+// 模拟接收方：排队中的事件各持有一份 QVariant 拷贝（与跨线程 frameReady 相同），处理时只保留最新一帧
+class Receiver : public QObject {
+public:
+    void post(const QVariant& data)
+    {
+        QMetaObject::invokeMethod(
+            this, [this, data] { held = data; }, Qt::QueuedConnection);
+    }
+
+    QVariant held;
+};
+
+QmVideoFrame makeFrame()
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = 64;
+    frame->height = 32;
+    av_frame_get_buffer(frame, 0);
+    QmVideoFrame result(frame, 0, 0);
+    av_frame_free(&frame);
+    return result;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what, int in_flight) {
+        out << "FAIL " << what << " in_flight=" << in_flight << "\n";
+        ++failures;
+    };
+    // 事件循环阻塞期间排队的帧全部在途，处理后只剩接收方保留的一帧，释放后归零
+    auto check = [&](const char* name, QmDeliveryTracker& tracker, const std::function<QVariant()>& make) {
+        Receiver receiver;
+        for (int i = 0; i < 3; ++i) {
+            receiver.post(tracker.track(make()));
+        }
+        if (const int in_flight = tracker.inFlight(); in_flight != 3) {
+            report(name, in_flight);
+        }
+        QCoreApplication::processEvents();
+        if (const int in_flight = tracker.inFlight(); in_flight != 1) {
+            report(name, in_flight);
+        }
+        receiver.held = QVariant();
+        if (const int in_flight = tracker.inFlight(); in_flight != 0) {
+            report(name, in_flight);
+        }
+    };
+
+    QmDeliveryTracker tracker;
+    check("image", tracker, [] {
+        QImage image(64, 32, QImage::Format_RGB888);
+        image.fill(0);
+        return QVariant(image);
+    });
+    const QmVideoFrame frame = makeFrame();
+    check("frame", tracker, [&frame] { return QVariant::fromValue(frame); });
+
+    // 缓冲池中的 QByteArray：发出期间池不持有副本，释放后交还池中复用
+    QmFramePool pool;
+    tracker.setBytePool(&pool);
+    check("bytearray", tracker, [&pool] { return QVariant(pool.allocByteArray(4096, [](char* data) { std::fill_n(data, 4096, 0); })); });
+    const qint64 misses = pool.stats().misses;
+    std::ignore = pool.allocByteArray(4096, [](char*) { });
+    if (pool.stats().misses != misses) {
+        report("bytearray-recycle", 0);
+    }
+
+    // clear 之后旧令牌的释放不影响新的计数
+    {
+        QVariant stale = tracker.track(QVariant(QImage(8, 8, QImage::Format_RGB888)));
+        tracker.clear();
+        stale = QVariant();
+        if (const int in_flight = tracker.inFlight(); in_flight != 0) {
+            report("clear", in_flight);
+        }
+    }
+    tracker.setLimit(1);
+    if (tracker.limit() != 2) {
+        report("min-limit", tracker.limit());
+    }
+
+    out << (failures == 0 ? "deliverytracker: ok" : "deliverytracker: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
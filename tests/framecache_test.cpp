@@ -0,0 +1,93 @@
+#include "qmframecache.h"
+#include <QTextStream>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+namespace {
+QmVideoFrame makeFrame(qint64 frame_no)
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_YUV420P;
+    frame->width = 64;
+    frame->height = 32;
+    av_frame_get_buffer(frame, 0);
+    QmVideoFrame result(frame, frame_no, frame_no * 40000);
+    av_frame_free(&frame);
+    return result;
+}
+} // namespace
+
+int main()
+{
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what) {
+        out << "FAIL " << what << "\n";
+        ++failures;
+    };
+    const qint64 frame_bytes = makeFrame(0).byteSize();
+
+    QmFrameCache cache;
+    if (cache.isEnabled()) {
+        report("disabled-by-default");
+    }
+    cache.insert(makeFrame(0));
+    if (cache.stats().frames != 0) {
+        report("insert-disabled");
+    }
+
+    // 预算可容纳 3 帧，插入第 4 帧时淘汰最久未使用的帧
+    cache.setBudget(frame_bytes * 3);
+    for (qint64 i = 0; i < 3; ++i) {
+        cache.insert(makeFrame(i));
+    }
+    if (cache.find(0).frameNumber() != 0) {
+        report("hit");
+    }
+    cache.insert(makeFrame(3));
+    if (!cache.find(1).isNull() || cache.find(0).isNull() || cache.find(2).isNull() || cache.find(3).isNull()) {
+        report("lru-order");
+    }
+    QmFrameCache::Stats stats = cache.stats();
+    if (stats.frames != 3 || stats.bytes != frame_bytes * 3 || stats.hits != 4 || stats.misses != 1) {
+        report("stats");
+    }
+
+    // 重复插入只刷新位置，不重复计数
+    cache.insert(makeFrame(0));
+    cache.insert(makeFrame(4));
+    if (cache.stats().bytes != frame_bytes * 3 || !cache.find(2).isNull() || cache.find(0).isNull()) {
+        report("reinsert");
+    }
+
+    // 超过预算的单帧不缓存
+    cache.setBudget(frame_bytes - 1);
+    if (cache.stats().frames != 0 || cache.stats().bytes != 0) {
+        report("budget-shrink");
+    }
+    cache.insert(makeFrame(5));
+    if (cache.stats().frames != 0) {
+        report("oversized");
+    }
+
+    // shrink 从最久未使用的一端释放，返回释放的字节数
+    cache.setBudget(frame_bytes * 4);
+    for (qint64 i = 0; i < 4; ++i) {
+        cache.insert(makeFrame(i));
+    }
+    if (cache.shrink(frame_bytes) != frame_bytes * 3 || cache.find(3).isNull() || !cache.find(2).isNull()) {
+        report("shrink");
+    }
+
+    // 帧号无效的帧不缓存
+    cache.clear();
+    cache.insert(makeFrame(-1));
+    if (cache.stats().frames != 0 || cache.stats().bytes != 0) {
+        report("invalid-frame-number");
+    }
+
+    out << (failures == 0 ? "framecache: ok" : "framecache: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
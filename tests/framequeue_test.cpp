@@ -0,0 +1,114 @@
+#include "qmframequeue.h"
+#include <QTextStream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+QmQueuedFrame makeFrame(qint64 frame_no)
+{
+    QmQueuedFrame frame;
+    frame.data = frame_no;
+    frame.frame_no = frame_no;
+    frame.bytes = 100;
+    return frame;
+}
+
+bool waitFor(const std::atomic_bool& flag)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!flag.load()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what) {
+        out << "FAIL " << what << "\n";
+        ++failures;
+    };
+
+    QmFrameQueue queue;
+    queue.setDepth(8);
+    queue.setWatermarks(2, 4);
+    int refills = 0;
+    queue.setRefillCallback([&refills] { ++refills; });
+
+    // 填充到高水位后停止接收，直到取到低水位
+    const quint64 generation = queue.generation();
+    for (int i = 0; i < 4; ++i) {
+        queue.push(makeFrame(i), generation, {});
+    }
+    if (queue.level() != 4 || queue.bytes() != 400 || queue.canPush()) {
+        report("high-watermark");
+    }
+    QmQueuedFrame frame;
+    queue.pop(&frame, {});
+    if (frame.frame_no != 0 || queue.canPush() || refills != 0) {
+        report("above-low-watermark");
+    }
+    queue.pop(&frame, {});
+    if (frame.frame_no != 1 || !queue.canPush() || refills != 1 || queue.bytes() != 200) {
+        report("low-watermark");
+    }
+
+    // 高水位之上的 push 阻塞到消费者取到低水位
+    for (int i = 4; i < 6 && queue.canPush(); ++i) {
+        queue.push(makeFrame(i), generation, {});
+    }
+    std::atomic_bool pushed { false };
+    std::jthread producer([&](std::stop_token st) {
+        pushed = queue.push(makeFrame(6), generation, st);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if (pushed) {
+        report("push-blocks");
+    }
+    queue.pop(&frame, {});
+    queue.pop(&frame, {});
+    if (!waitFor(pushed) || queue.level() != 3) {
+        report("push-resumes");
+    }
+    producer.request_stop();
+    producer.join();
+
+    // clear 后代数加一，旧代数的帧直接丢弃
+    queue.clear();
+    if (queue.generation() != generation + 1 || queue.level() != 0 || queue.bytes() != 0 || refills != 3) {
+        report("clear");
+    }
+    if (!queue.push(makeFrame(7), generation, {}) || queue.level() != 0) {
+        report("stale-generation");
+    }
+
+    // finish 后取空队列再返回 false
+    queue.push(makeFrame(8), queue.generation(), {});
+    queue.finish();
+    if (!queue.pop(&frame, {}) || frame.frame_no != 8 || queue.pop(&frame, {})) {
+        report("finish");
+    }
+
+    // 停止请求唤醒阻塞的 pop
+    queue.clear();
+    std::stop_source stop;
+    std::jthread consumer([&] {
+        QmQueuedFrame unused;
+        if (queue.pop(&unused, stop.get_token())) {
+            report("stop-pop");
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    stop.request_stop();
+    consumer.join();
+
+    out << (failures == 0 ? "framequeue: ok" : "framequeue: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "qmframering.h"
+#include <QTextStream>
+#include <thread>
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+int main()
+{
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what) {
+        out << "FAIL " << what << "\n";
+        ++failures;
+    };
+    AVFrame* frame = av_frame_alloc();
+    frame->format = AV_PIX_FMT_GRAY8;
+    frame->width = 16;
+    frame->height = 16;
+    av_frame_get_buffer(frame, 0);
+
+    // 容量向上取整到 2 的幂，至少为 2
+    if (QmFrameRing(5).capacity() != 8 || QmFrameRing(1).capacity() != 2) {
+        report("capacity");
+    }
+
+    // 写满后拒绝写入，读写位置多次绕回后仍保持先进先出
+    {
+        QmFrameRing ring(4);
+        qint64 next_push = 0;
+        qint64 next_pop = 0;
+        QmVideoFrame popped;
+        for (int round = 0; round < 5; ++round) {
+            while (ring.push(QmVideoFrame(frame, next_push))) {
+                ++next_push;
+            }
+            if (ring.size() != 4) {
+                report("full");
+            }
+            for (int i = 0; i < 3; ++i) {
+                if (!ring.pop(&popped) || popped.frameNumber() != next_pop++) {
+                    report("wraparound");
+                }
+            }
+        }
+        while (ring.pop(&popped)) {
+            if (popped.frameNumber() != next_pop++) {
+                report("drain");
+            }
+        }
+        if (next_pop != next_push || ring.size() != 0) {
+            report("drain-count");
+        }
+    }
+
+    // 取出后槽位不再引用帧
+    {
+        QmFrameRing ring(2);
+        const QmVideoFrame held(frame, 0);
+        ring.push(held);
+        QmVideoFrame popped;
+        ring.pop(&popped);
+        popped = QmVideoFrame();
+        if (!held.isDetached()) {
+            report("slot-release");
+        }
+    }
+
+    // 两个线程并发读写，消费者按顺序收到全部帧
+    {
+        constexpr qint64 kFrames = 20000;
+        QmFrameRing ring(8);
+        std::jthread producer([&ring, frame] {
+            for (qint64 i = 0; i < kFrames; ++i) {
+                const QmVideoFrame item(frame, i);
+                while (!ring.push(item)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        qint64 expected = 0;
+        QmVideoFrame popped;
+        while (expected < kFrames && ring.waitPop(&popped, std::chrono::seconds(5))) {
+            if (popped.frameNumber() != expected) {
+                break;
+            }
+            ++expected;
+        }
+        producer.join();
+        if (expected != kFrames) {
+            report("spsc-order");
+        }
+        if (ring.waitPop(&popped, std::chrono::milliseconds(1))) {
+            report("spsc-empty");
+        }
+    }
+
+    av_frame_free(&frame);
+    out << (failures == 0 ? "framering: ok" : "framering: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "qmmemorybudget.h"
+#include <QTextStream>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace {
+// 模拟一路解码器：缓存可以全部回收，预读队列不可回收
+struct FakeClient {
+    qint64 cache { 0 };
+    qint64 queue { 0 };
+    int reclaimed { 0 };
+
+    QmMemoryBudget::Usage usage() const
+    {
+        QmMemoryBudget::Usage usage;
+        usage.bytes[QmMemoryBudget::FrameCache] = cache;
+        usage.bytes[QmMemoryBudget::LookaheadQueue] = queue;
+        return usage;
+    }
+
+    QmMemoryBudget::Usage reclaim(qint64 bytes)
+    {
+        ++reclaimed;
+        cache -= std::min(cache, bytes);
+        return usage();
+    }
+};
+} // namespace
+
+int main()
+{
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what) {
+        out << "FAIL " << what << "\n";
+        ++failures;
+    };
+    constexpr qint64 kMB = 1024 * 1024;
+
+    QmMemoryBudget budget;
+    FakeClient low;
+    FakeClient high;
+    const int low_id = budget.registerClient("low", 0, [&low](qint64 bytes) { return low.reclaim(bytes); });
+    const int high_id = budget.registerClient("high", 10, [&high](qint64 bytes) { return high.reclaim(bytes); });
+
+    // 不限制时只记账
+    low.cache = 40 * kMB;
+    high.cache = 40 * kMB;
+    high.queue = 10 * kMB;
+    budget.report(low_id, low.usage());
+    budget.report(high_id, high.usage());
+    if (budget.usage() != 90 * kMB || low.reclaimed != 0 || budget.clientStats(high_id).usage.total() != 50 * kMB) {
+        report("accounting");
+    }
+
+    // 超出预算时先回收低优先级的一路，足够时不触及高优先级
+    budget.setBudget(60 * kMB);
+    if (budget.usage() > 60 * kMB || low.cache != 10 * kMB || high.reclaimed != 0) {
+        report("low-priority-first");
+    }
+    if (budget.clientStats(low_id).reclaimed_bytes != 30 * kMB || budget.clientStats(low_id).reclaim_count != 1) {
+        report("reclaim-stats");
+    }
+
+    // 低优先级回收不够时继续回收高优先级，不可回收的部分保留
+    high.queue = 30 * kMB;
+    budget.report(high_id, high.usage());
+    if (budget.usage() > 60 * kMB || low.cache != 0 || high.cache != 30 * kMB || high.queue != 30 * kMB) {
+        report("escalate");
+    }
+    if (budget.peakUsage() < 80 * kMB || budget.headroom() != 60 * kMB - budget.usage()) {
+        report("peak-headroom");
+    }
+
+    // 调整优先级后回收顺序随之改变
+    budget.setPriority(low_id, 20);
+    low.cache = 20 * kMB;
+    budget.report(low_id, low.usage());
+    if (high.cache != 10 * kMB || low.cache != 20 * kMB) {
+        report("set-priority");
+    }
+
+    // 多线程并发上报，回收完成后总量回到预算以内
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&budget, t] {
+            std::vector<std::pair<int, qint64>> clients;
+            for (int i = 0; i < 8; ++i) {
+                auto* cache = new qint64(0);
+                const int id = budget.registerClient("worker", t, [cache](qint64 bytes) {
+                    *cache -= std::min(*cache, bytes);
+                    QmMemoryBudget::Usage usage;
+                    usage.bytes[QmMemoryBudget::FrameCache] = *cache;
+                    return usage;
+                });
+                *cache = 4 * kMB;
+                QmMemoryBudget::Usage usage;
+                usage.bytes[QmMemoryBudget::FrameCache] = *cache;
+                budget.report(id, usage);
+                budget.unregisterClient(id);
+                delete cache;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    budget.report(low_id, low.usage());
+    if (budget.usage() > 60 * kMB || budget.clients().size() != 2) {
+        report("concurrent");
+    }
+
+    budget.unregisterClient(low_id);
+    budget.unregisterClient(high_id);
+    if (budget.usage() != 0 || !budget.clients().isEmpty()) {
+        report("unregister");
+    }
+
+    out << (failures == 0 ? "memorybudget: ok" : "memorybudget: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
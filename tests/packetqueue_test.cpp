@@ -0,0 +1,175 @@
+#include "qmpacketqueue.h"
+#include <QTextStream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace {
+AVPacket* makePacket(int size)
+{
+    AVPacket* packet = av_packet_alloc();
+    av_new_packet(packet, size);
+    return packet;
+}
+
+// 在另一个线程中 push，超时未完成视为阻塞；返回后该线程仍在等待，由调用方取出 packet 使其完成
+bool pushBlocks(QmPacketQueue& queue, int size, std::jthread* thread, std::atomic_bool* pushed)
+{
+    *thread = std::jthread([&queue, size, pushed](std::stop_token st) {
+        *pushed = queue.push(makePacket(size), queue.generation(), st);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    return !*pushed;
+}
+
+bool waitFor(const std::atomic_bool& flag)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!flag.load()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what) {
+        out << "FAIL " << what << "\n";
+        ++failures;
+    };
+    AVPacket* packet = av_packet_alloc();
+
+    // 包数限制
+    {
+        QmPacketQueue queue;
+        queue.setLimits(3, 1 << 20);
+        for (int i = 0; i < 3; ++i) {
+            queue.push(makePacket(100), queue.generation(), {});
+        }
+        if (queue.count() != 3 || queue.bytes() != 300) {
+            report("count-accounting");
+        }
+        std::jthread producer;
+        std::atomic_bool pushed { false };
+        if (!pushBlocks(queue, 100, &producer, &pushed)) {
+            report("count-limit");
+        }
+        queue.pop(packet);
+        av_packet_unref(packet);
+        if (!waitFor(pushed) || queue.count() != 3) {
+            report("count-resume");
+        }
+        producer.request_stop();
+        producer.join();
+    }
+
+    // 字节数限制：达到上限后阻塞，空队列总能放入超过上限的单个 packet
+    {
+        QmPacketQueue queue;
+        queue.setLimits(100, 1000);
+        queue.push(makePacket(4000), queue.generation(), {});
+        if (queue.count() != 1 || queue.bytes() != 4000) {
+            report("oversized");
+        }
+        std::jthread producer;
+        std::atomic_bool pushed { false };
+        if (!pushBlocks(queue, 100, &producer, &pushed)) {
+            report("byte-limit");
+        }
+        queue.pop(packet);
+        if (packet->size != 4000) {
+            report("pop-order");
+        }
+        av_packet_unref(packet);
+        if (!waitFor(pushed) || queue.bytes() != 100) {
+            report("byte-resume");
+        }
+        producer.request_stop();
+        producer.join();
+    }
+
+    // finish 后取空队列再返回 false，旧代数的 finish 被忽略
+    {
+        QmPacketQueue queue;
+        const quint64 generation = queue.generation();
+        queue.push(makePacket(10), generation, {});
+        queue.push(makePacket(20), generation, {});
+        queue.finish(generation + 1);
+        queue.finish(generation);
+        if (queue.isFinished()) {
+            report("finish-pending");
+        }
+        if (!queue.pop(packet) || packet->size != 10) {
+            report("finish-drain");
+        }
+        av_packet_unref(packet);
+        if (!queue.pop(packet) || packet->size != 20) {
+            report("finish-drain");
+        }
+        av_packet_unref(packet);
+        if (queue.pop(packet) || !queue.isFinished()) {
+            report("finish-end");
+        }
+
+        // clear 开始新的一代，旧代数的 packet 被丢弃
+        queue.clear();
+        if (queue.isFinished() || queue.generation() != generation + 1) {
+            report("clear");
+        }
+        if (!queue.push(makePacket(10), generation, {}) || queue.count() != 0) {
+            report("stale-generation");
+        }
+
+        // abort 唤醒阻塞的 pop；seek 的 clear 不解除 abort，reset 之后恢复
+        std::jthread consumer([&queue] {
+            AVPacket* unused = av_packet_alloc();
+            queue.pop(unused);
+            av_packet_free(&unused);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.abort();
+        consumer.join();
+        if (queue.push(makePacket(10), queue.generation(), {})) {
+            report("abort");
+        }
+        queue.clear();
+        if (queue.push(makePacket(10), queue.generation(), {}) || queue.pop(packet)) {
+            report("abort-survives-clear");
+        }
+        queue.reset();
+        if (!queue.push(makePacket(10), queue.generation(), {}) || queue.count() != 1) {
+            report("abort-reset");
+        }
+    }
+
+    // 停止请求唤醒阻塞的 pop
+    {
+        QmPacketQueue queue;
+        std::atomic_bool popped { true };
+        std::jthread consumer([&queue, &popped](std::stop_token st) {
+            AVPacket* unused = av_packet_alloc();
+            popped = queue.pop(unused, st);
+            av_packet_free(&unused);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        consumer.request_stop();
+        consumer.join();
+        if (popped) {
+            report("stop-pop");
+        }
+    }
+
+    av_packet_free(&packet);
+    out << (failures == 0 ? "packetqueue: ok" : "packetqueue: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "qmdecoderscheduler.h"
+#include <QTextStream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+// 阻塞一个工作线程直到 open，用于在任务执行前排好队列
+class Gate {
+public:
+    void wait()
+    {
+        std::unique_lock lock(mutex_);
+        entered_ = true;
+        cv_.notify_all();
+        cv_.wait(lock, [this] { return opened_; });
+    }
+    void waitEntered()
+    {
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, [this] { return entered_; });
+    }
+    void open()
+    {
+        std::scoped_lock lock(mutex_);
+        opened_ = true;
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool entered_ { false };
+    bool opened_ { false };
+};
+
+bool waitFor(const std::atomic_int& counter, int expected)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (counter.load() < expected) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what) {
+        out << "FAIL " << what << "\n";
+        ++failures;
+    };
+
+    const int cores = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    if (QmDecoderScheduler(cores * 4).threadCount() != cores || QmDecoderScheduler(0).threadCount() != cores) {
+        report("thread-cap");
+    }
+
+    // 单线程时按截止时间执行，与提交顺序无关；已过截止时间的任务计入 deadline_misses
+    {
+        QmDecoderScheduler scheduler(1);
+        const int gate_stream = scheduler.registerStream("gate");
+        const int stream = scheduler.registerStream("ordered");
+        Gate gate;
+        scheduler.post(gate_stream, 0, [&gate] { gate.wait(); });
+        gate.waitEntered();
+
+        std::mutex order_mutex;
+        std::vector<int> order;
+        std::atomic_int done { 0 };
+        const qint64 now = QmDecoderScheduler::now();
+        for (int i : { 5, 1, 4, 0, 3, 2 }) {
+            scheduler.post(stream, now + i * 1000000, [&, i] {
+                std::scoped_lock lock(order_mutex);
+                order.push_back(i);
+                ++done;
+            });
+        }
+        scheduler.post(stream, now - 1000, [&] {
+            std::scoped_lock lock(order_mutex);
+            order.push_back(-1);
+            ++done;
+        });
+        gate.open();
+        if (!waitFor(done, 7)) {
+            report("edf-timeout");
+        } else if (order != std::vector<int> { -1, 0, 1, 2, 3, 4, 5 }) {
+            report("edf-order");
+        }
+        const QmDecoderScheduler::StreamStats stats = scheduler.streamStats(stream);
+        if (stats.tasks != 7 || stats.deadline_misses < 1 || stats.name != "ordered") {
+            report("stream-stats");
+        }
+        if (scheduler.stats().size() != 2 || scheduler.fairness() <= 0 || scheduler.fairness() > 1) {
+            report("fairness");
+        }
+    }
+
+    // cancel 丢弃尚未执行的任务
+    {
+        QmDecoderScheduler scheduler(1);
+        const int gate_stream = scheduler.registerStream();
+        const int stream = scheduler.registerStream();
+        Gate gate;
+        scheduler.post(gate_stream, 0, [&gate] { gate.wait(); });
+        gate.waitEntered();
+        std::atomic_int executed { 0 };
+        for (int i = 0; i < 4; ++i) {
+            scheduler.post(stream, 0, [&executed] { ++executed; });
+        }
+        scheduler.cancel(stream);
+        gate.open();
+        scheduler.unregisterStream(gate_stream);
+        scheduler.unregisterStream(stream);
+        if (executed != 0) {
+            report("cancel");
+        }
+    }
+
+    // 一个工作线程被阻塞时，分配到它堆中的任务由其他线程窃取执行
+    if (cores >= 2) {
+        QmDecoderScheduler scheduler(2);
+        const int stream = scheduler.registerStream();
+        Gate gate;
+        scheduler.post(stream, 0, [&gate] { gate.wait(); });
+        gate.waitEntered();
+        std::atomic_int done { 0 };
+        for (int i = 0; i < 8; ++i) {
+            scheduler.post(stream, QmDecoderScheduler::now(), [&done] { ++done; });
+        }
+        if (!waitFor(done, 8)) {
+            report("work-stealing");
+        }
+        gate.open();
+    }
+
+    out << (failures == 0 ? "scheduler: ok" : "scheduler: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "qmvideoclock.h"
+#include <QTextStream>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace {
+using std::chrono::steady_clock;
+
+qint64 microsecondsSince(steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - start).count();
+}
+} // namespace
+
+int main()
+{
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what) {
+        out << "FAIL " << what << "\n";
+        ++failures;
+    };
+    constexpr auto kSleep = std::chrono::milliseconds(30);
+    constexpr qint64 kSleepUs = 30000;
+
+    // 时钟的推进量夹在 rate × 睡眠时长与 rate × 两次读取之间的实际时长之间
+    auto check_rate = [&](const char* what, QmVideoClock& clock, double rate) {
+        const auto start = steady_clock::now();
+        const qint64 before = clock.time();
+        std::this_thread::sleep_for(kSleep);
+        const qint64 after = clock.time();
+        const qint64 wall_us = microsecondsSince(start);
+        const double advanced = static_cast<double>(after - before) * (rate < 0 ? -1 : 1);
+        if (advanced < std::abs(rate) * kSleepUs - 1 || advanced > std::abs(rate) * wall_us + 1) {
+            report(what);
+        }
+    };
+
+    QmVideoClock clock;
+    clock.setTime(1000000);
+    check_rate("rate-1", clock, 1.0);
+
+    // 修改 rate 不改变当前时间
+    {
+        const auto start = steady_clock::now();
+        const qint64 before = clock.time();
+        clock.setRate(2.0);
+        const qint64 after = clock.time();
+        if (after < before || after - before > 2 * microsecondsSince(start) + 1) {
+            report("rate-continuity");
+        }
+    }
+    check_rate("rate-2", clock, 2.0);
+    clock.setRate(0.5);
+    check_rate("rate-0.5", clock, 0.5);
+    clock.setRate(-1.0);
+    check_rate("rate-negative", clock, -1.0);
+    if (clock.rate() != -1.0) {
+        report("rate-getter");
+    }
+
+    // 暂停时停在当前时间，暂停期间不变
+    clock.setRate(1.0);
+    const auto pause_start = steady_clock::now();
+    const qint64 before_pause = clock.time();
+    clock.setPaused(true);
+    const qint64 paused_at = clock.time();
+    if (paused_at < before_pause || paused_at - before_pause > microsecondsSince(pause_start) + 1) {
+        report("pause-continuity");
+    }
+    std::this_thread::sleep_for(kSleep);
+    if (!clock.isPaused() || clock.time() != paused_at) {
+        report("pause");
+    }
+
+    // 恢复后从暂停时的时间继续，不计入暂停的时长
+    const auto resume_start = steady_clock::now();
+    clock.setPaused(false);
+    const qint64 resumed = clock.time();
+    if (resumed < paused_at || resumed - paused_at > microsecondsSince(resume_start) + 1) {
+        report("resume");
+    }
+
+    // 暂停期间仍可校准
+    clock.setPaused(true);
+    clock.setTime(5000000);
+    if (clock.time() != 5000000) {
+        report("set-time-paused");
+    }
+    clock.setPaused(false);
+    check_rate("rate-resumed", clock, 1.0);
+
+    out << (failures == 0 ? "videoclock: ok" : "videoclock: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
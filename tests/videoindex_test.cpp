@@ -0,0 +1,155 @@
+#include "qmvideoindex.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace {
+// 与 qmvideoindex.cpp 中的缓存文件头一致
+struct CacheHeader {
+    char magic[8];
+    quint32 version;
+    quint32 byte_order;
+    quint64 frame_count;
+    quint64 keyframe_count;
+};
+
+bool writeCache(const QString& path, const std::vector<qint64>& pts, const std::vector<qint64>& keyframes)
+{
+    CacheHeader header {};
+    std::memcpy(header.magic, "QMVIDX\0\0", sizeof(header.magic));
+    header.version = 1;
+    header.byte_order = 0x01020304;
+    header.frame_count = pts.size();
+    header.keyframe_count = keyframes.size();
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(pts.data()), pts.size() * sizeof(qint64));
+    file.write(reinterpret_cast<const char*>(keyframes.data()), keyframes.size() * sizeof(qint64));
+    return true;
+}
+} // namespace
+
+int main()
+{
+    QTextStream out(stdout);
+    int failures = 0;
+    auto report = [&](const char* what) {
+        out << "FAIL " << what << "\n";
+        ++failures;
+    };
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        out << "FAIL temporary dir\n";
+        return 1;
+    }
+
+    // 10 帧，每帧 pts 间隔 512，关键帧为 0、4、8
+    std::vector<qint64> pts;
+    for (qint64 i = 0; i < 10; ++i) {
+        pts.push_back(1000 + i * 512);
+    }
+    const std::vector<qint64> keyframes { 0, 4, 8 };
+    const QString source = dir.filePath("source.qmidx");
+    writeCache(source, pts, keyframes);
+
+    QmVideoIndex index;
+    if (!index.load(source) || !index.isValid() || index.frameCount() != 10) {
+        report("load");
+    }
+    if (index.ptsOfFrame(3) != 1000 + 3 * 512 || index.frameOfPts(1000 + 5 * 512) != 5 || index.frameOfPts(1000 + 5 * 512 - 1) != 5) {
+        report("pts-lookup");
+    }
+    if (index.keyframeBefore(7) != 4 || index.keyframeBefore(8) != 8 || index.keyframeAfter(4) != 8 || index.keyframeAfter(8) != -1) {
+        report("keyframe-lookup");
+    }
+
+    // 保存后重新加载，内容逐字节一致
+    const QString copy = dir.filePath("copy.qmidx");
+    QmVideoIndex reloaded;
+    if (!index.save(copy) || !reloaded.load(copy)) {
+        report("round-trip");
+    } else {
+        QFile a(source);
+        QFile b(copy);
+        a.open(QIODevice::ReadOnly);
+        b.open(QIODevice::ReadOnly);
+        if (a.readAll() != b.readAll() || reloaded.frameCount() != 10 || reloaded.keyframeBefore(9) != 8) {
+            report("round-trip-content");
+        }
+    }
+
+    // 移动后映射仍然有效
+    QmVideoIndex moved(std::move(reloaded));
+    if (!moved.isValid() || moved.ptsOfFrame(9) != 1000 + 9 * 512) {
+        report("move");
+    }
+
+    // 损坏的缓存文件必须被拒绝
+    auto rejects = [&](const char* what, const std::vector<qint64>& bad_pts, const std::vector<qint64>& bad_keyframes) {
+        const QString path = dir.filePath(QString::fromLatin1(what) + ".qmidx");
+        writeCache(path, bad_pts, bad_keyframes);
+        QmVideoIndex bad;
+        if (bad.load(path) || bad.isValid()) {
+            report(what);
+        }
+    };
+    std::vector<qint64> unsorted = pts;
+    std::swap(unsorted[2], unsorted[3]);
+    rejects("unsorted-pts", unsorted, keyframes);
+    std::vector<qint64> duplicated = pts;
+    duplicated[5] = duplicated[4];
+    rejects("duplicated-pts", duplicated, keyframes);
+    rejects("unsorted-keyframes", pts, { 0, 8, 4 });
+    rejects("keyframe-out-of-range", pts, { 0, 4, 10 });
+    rejects("negative-keyframe", pts, { -1, 4 });
+    rejects("no-keyframes", pts, {});
+
+    // 截断与头部计数不符
+    {
+        const QString path = dir.filePath("truncated.qmidx");
+        QFile::copy(source, path);
+        QFile file(path);
+        file.open(QIODevice::ReadWrite);
+        file.resize(file.size() - sizeof(qint64));
+        file.close();
+        QmVideoIndex bad;
+        if (bad.load(path)) {
+            report("truncated");
+        }
+    }
+    {
+        const QString path = dir.filePath("huge-count.qmidx");
+        QFile::copy(source, path);
+        QFile file(path);
+        file.open(QIODevice::ReadWrite);
+        const quint64 huge = quint64(1) << 61;
+        file.seek(offsetof(CacheHeader, frame_count));
+        file.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+        file.close();
+        QmVideoIndex bad;
+        if (bad.load(path)) {
+            report("huge-count");
+        }
+    }
+    {
+        const QString path = dir.filePath("bad-magic.qmidx");
+        QFile::copy(source, path);
+        QFile file(path);
+        file.open(QIODevice::ReadWrite);
+        file.write("XXXX");
+        file.close();
+        QmVideoIndex bad;
+        if (bad.load(path)) {
+            report("bad-magic");
+        }
+    }
+
+    out << (failures == 0 ? "videoindex: ok" : "videoindex: failed") << "\n";
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
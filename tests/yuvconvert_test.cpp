@@ -0,0 +1,212 @@
+#include "qmyuvconvert.h"
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libswscale/swscale.h>
+}
+
+namespace {
+// 各平面行宽大于可见宽度，用于检查 stride 处理
+struct TestFrame {
+    int width { 0 };
+    int height { 0 };
+    std::vector<uint8_t> planes[3];
+    int stride[3] {};
+    const uint8_t* data[3] {};
+};
+
+// smooth 为真时色度逐点至多变化 1，使 swscale 的色度插值与最近邻取样只差舍入
+TestFrame makeFrame(int width, int height, bool smooth, std::mt19937& rng)
+{
+    TestFrame frame;
+    frame.width = width;
+    frame.height = height;
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_height = (height + 1) / 2;
+    frame.stride[0] = width + 13;
+    frame.stride[1] = chroma_width + 7;
+    frame.stride[2] = chroma_width + 7;
+    std::uniform_int_distribution<int> dist(0, 255);
+    frame.planes[0].resize(static_cast<size_t>(frame.stride[0]) * height);
+    for (auto& value : frame.planes[0]) {
+        value = static_cast<uint8_t>(dist(rng));
+    }
+    for (int i = 1; i < 3; ++i) {
+        frame.planes[i].resize(static_cast<size_t>(frame.stride[i]) * chroma_height);
+        for (int cy = 0; cy < chroma_height; ++cy) {
+            for (int cx = 0; cx < chroma_width; ++cx) {
+                const int t = (cx + cy + i * 77) % 256;
+                frame.planes[i][cy * frame.stride[i] + cx] = static_cast<uint8_t>(smooth ? 64 + (t < 128 ? t : 255 - t) : dist(rng));
+            }
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        frame.data[i] = frame.planes[i].data();
+    }
+    return frame;
+}
+
+int bytesPerPixel(QmYuvConvert::PixelFormat format)
+{
+    return format == QmYuvConvert::Rgb24 ? 3 : 4;
+}
+
+// 双精度参考实现
+std::vector<uint8_t> reference(const TestFrame& frame, int dst_stride, QmYuvConvert::PixelFormat format, QmYuvConvert::ColorSpace space,
+    QmYuvConvert::ColorRange range)
+{
+    const double kr = (space == QmYuvConvert::Bt709) ? 0.2126 : 0.299;
+    const double kb = (space == QmYuvConvert::Bt709) ? 0.0722 : 0.114;
+    const double kg = 1.0 - kr - kb;
+    const bool limited = range == QmYuvConvert::LimitedRange;
+    const double y_scale = limited ? 255.0 / 219.0 : 1.0;
+    const double c_scale = limited ? 255.0 / 224.0 : 1.0;
+    const int bpp = bytesPerPixel(format);
+    const int r_pos = (format == QmYuvConvert::Bgra) ? 2 : 0;
+    auto to_pixel = [](double value) { return static_cast<uint8_t>(std::clamp(std::lround(value), 0L, 255L)); };
+    std::vector<uint8_t> out(static_cast<size_t>(dst_stride) * frame.height, 0);
+    for (int y = 0; y < frame.height; ++y) {
+        for (int x = 0; x < frame.width; ++x) {
+            const double yy = (frame.data[0][y * frame.stride[0] + x] - (limited ? 16 : 0)) * y_scale;
+            const double uu = (frame.data[1][y / 2 * frame.stride[1] + x / 2] - 128) * c_scale;
+            const double vv = (frame.data[2][y / 2 * frame.stride[2] + x / 2] - 128) * c_scale;
+            uint8_t* p = out.data() + y * dst_stride + x * bpp;
+            p[r_pos] = to_pixel(yy + 2 * (1 - kr) * vv);
+            p[1] = to_pixel(yy - 2 * (1 - kb) * kb / kg * uu - 2 * (1 - kr) * kr / kg * vv);
+            p[2 - r_pos] = to_pixel(yy + 2 * (1 - kb) * uu);
+            if (bpp == 4) {
+                p[3] = 255;
+            }
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> swscaleConvert(const TestFrame& frame, int dst_stride, QmYuvConvert::PixelFormat format, QmYuvConvert::ColorSpace space,
+    QmYuvConvert::ColorRange range)
+{
+    const AVPixelFormat dst_fmt = (format == QmYuvConvert::Rgb24) ? AV_PIX_FMT_RGB24 : (format == QmYuvConvert::Rgba) ? AV_PIX_FMT_RGBA : AV_PIX_FMT_BGRA;
+    std::vector<uint8_t> out(static_cast<size_t>(dst_stride) * frame.height, 0);
+    SwsContext* ctx = sws_getContext(frame.width, frame.height, AV_PIX_FMT_YUV420P, frame.width, frame.height, dst_fmt, SWS_POINT, nullptr, nullptr, nullptr);
+    if (!ctx) {
+        return {};
+    }
+    sws_setColorspaceDetails(ctx, sws_getCoefficients(space == QmYuvConvert::Bt709 ? SWS_CS_ITU709 : SWS_CS_ITU601), range == QmYuvConvert::FullRange,
+        sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+    uint8_t* dst[4] { out.data(), nullptr, nullptr, nullptr };
+    const int dst_linesize[4] { dst_stride, 0, 0, 0 };
+    sws_scale(ctx, frame.data, frame.stride, 0, frame.height, dst, dst_linesize);
+    sws_freeContext(ctx);
+    return out;
+}
+
+// 只比较可见像素，返回最大差值
+int maxDiff(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, int row_bytes, int stride, int height)
+{
+    if (a.size() != b.size()) {
+        return 256;
+    }
+    int diff = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < row_bytes; ++x) {
+            diff = std::max(diff, std::abs(a[y * stride + x] - b[y * stride + x]));
+        }
+    }
+    return diff;
+}
+
+// 行尾填充区应保持不变
+bool paddingIntact(const std::vector<uint8_t>& data, int row_bytes, int stride, int height, uint8_t fill)
+{
+    for (int y = 0; y < height; ++y) {
+        for (int x = row_bytes; x < stride; ++x) {
+            if (data[y * stride + x] != fill) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+const char* isaName(QmYuvConvert::Isa isa)
+{
+    switch (isa) {
+    case QmYuvConvert::Sse41Isa:
+        return "sse4.1";
+    case QmYuvConvert::Avx2Isa:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+}
+
+int main()
+{
+    QTextStream out(stdout);
+    constexpr uint8_t kFill = 0xCD;
+    // 与 swscale 的最大允许差值，其 yuv2rgb 查表存在约 ±2 的舍入误差
+    constexpr int kSwscaleTolerance = 3;
+    const QmYuvConvert::Isa detected = QmYuvConvert::detectedIsa();
+    out << "detected isa: " << isaName(detected) << "\n";
+
+    std::mt19937 rng(20240501);
+    const int sizes[][2] { { 1, 1 }, { 2, 2 }, { 17, 3 }, { 33, 9 }, { 50, 4 }, { 64, 48 }, { 67, 35 }, { 1920, 4 } };
+    int failures = 0;
+    for (const auto& size : sizes) {
+        const TestFrame noisy = makeFrame(size[0], size[1], false, rng);
+        const TestFrame smooth = makeFrame(size[0], size[1], true, rng);
+        for (auto format : { QmYuvConvert::Rgb24, QmYuvConvert::Rgba, QmYuvConvert::Bgra }) {
+            const int row_bytes = size[0] * bytesPerPixel(format);
+            const int stride = row_bytes + 19;
+            for (auto space : { QmYuvConvert::Bt601, QmYuvConvert::Bt709 }) {
+                for (auto range : { QmYuvConvert::LimitedRange, QmYuvConvert::FullRange }) {
+                    auto convert = [&](const TestFrame& frame, QmYuvConvert::Isa isa) {
+                        std::vector<uint8_t> data(static_cast<size_t>(stride) * frame.height, kFill);
+                        QmYuvConvert::convert(frame.data, frame.stride, data.data(), stride, frame.width, frame.height, format, space, range, isa);
+                        return data;
+                    };
+                    auto report = [&](const char* what, int diff) {
+                        out << "FAIL " << what << " " << size[0] << "x" << size[1] << " format=" << format << " space=" << space
+                            << " range=" << range << " diff=" << diff << "\n";
+                        ++failures;
+                    };
+
+                    const std::vector<uint8_t> scalar = convert(noisy, QmYuvConvert::ScalarIsa);
+                    if (!paddingIntact(scalar, row_bytes, stride, size[1], kFill)) {
+                        report("scalar-padding", 0);
+                    }
+                    const int ref_diff = maxDiff(scalar, reference(noisy, stride, format, space, range), row_bytes, stride, size[1]);
+                    if (ref_diff > 1) {
+                        report("scalar-vs-reference", ref_diff);
+                    }
+                    for (auto isa : { QmYuvConvert::Sse41Isa, QmYuvConvert::Avx2Isa }) {
+                        if (isa > detected) {
+                            continue;
+                        }
+                        const std::vector<uint8_t> simd = convert(noisy, isa);
+                        const int simd_diff = maxDiff(simd, scalar, row_bytes, stride, size[1]);
+                        if (simd_diff != 0) {
+                            report(isaName(isa), simd_diff);
+                        }
+                        if (!paddingIntact(simd, row_bytes, stride, size[1], kFill)) {
+                            report("simd-padding", 0);
+                        }
+                    }
+
+                    const int sws_diff = maxDiff(convert(smooth, QmYuvConvert::AutoIsa), swscaleConvert(smooth, stride, format, space, range), row_bytes,
+                        stride, size[1]);
+                    if (sws_diff > kSwscaleTolerance) {
+                        report("vs-swscale", sws_diff);
+                    }
+                }
+            }
+        }
+    }
+    out << (failures ? "FAILED " : "passed ") << failures << "\n";
+    return failures ? 1 : 0;
+}
\ No newline at end of file
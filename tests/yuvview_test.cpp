@@ -0,0 +1,212 @@
+#include "qmyuvmosaicview.h"
+#include "qmyuvview.h"
+#include <QApplication>
+#include <QColor>
+#include <QImage>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+// 无法创建 GL 上下文时跳过，CTest 中以 SKIP_RETURN_CODE 识别
+constexpr int kSkipped = 77;
+
+struct Input {
+    QmYuvView::InputFormat format;
+    // 每行末尾额外的填充字节，为 0 时按紧密排列传入
+    int padding;
+};
+
+// 10 位格式的样本取 8 位值乘以 4，p010 再左移到高 10 位
+void fillPlane(char* row_begin, int stride, const QSize& size, int components, int sample_size, const int values[2], int shift)
+{
+    for (int y = 0; y < size.height(); ++y) {
+        char* row = row_begin + y * stride;
+        for (int x = 0; x < size.width() * components; ++x) {
+            const int value = values[x % components];
+            if (sample_size == 1) {
+                row[x] = static_cast<char>(value);
+            } else {
+                const quint16 sample = static_cast<quint16>((value * 4) << shift);
+                memcpy(row + x * 2, &sample, 2);
+            }
+        }
+    }
+}
+
+QByteArray solidFrame(const QSize& size, const Input& input, uchar y, uchar u, uchar v, QList<int>* linesizes)
+{
+    const bool semi_planar = input.format == QmYuvView::Nv12 || input.format == QmYuvView::P010;
+    const int sample_size = (input.format == QmYuvView::Yuv420p || input.format == QmYuvView::Nv12) ? 1 : 2;
+    const int shift = input.format == QmYuvView::P010 ? 6 : 0;
+    const QSize chroma_size((size.width() + 1) / 2, (size.height() + 1) / 2);
+    const int plane_count = semi_planar ? 2 : 3;
+    linesizes->clear();
+    qsizetype total = 0;
+    for (int plane = 0; plane < plane_count; ++plane) {
+        const int components = (plane > 0 && semi_planar) ? 2 : 1;
+        const QSize plane_size = plane == 0 ? size : chroma_size;
+        linesizes->append(plane_size.width() * components * sample_size + input.padding);
+        total += static_cast<qsizetype>(linesizes->back()) * plane_size.height();
+    }
+    QByteArray data(total, '\x5a');
+    char* dst = data.data();
+    const int luma[2] { y, y };
+    const int uv[2] { u, v };
+    const int only_u[2] { u, u };
+    const int only_v[2] { v, v };
+    for (int plane = 0; plane < plane_count; ++plane) {
+        const QSize plane_size = plane == 0 ? size : chroma_size;
+        const int* values = plane == 0 ? luma : semi_planar ? uv : plane == 1 ? only_u : only_v;
+        fillPlane(dst, (*linesizes)[plane], plane_size, (plane > 0 && semi_planar) ? 2 : 1, sample_size, values, shift);
+        dst += static_cast<qsizetype>((*linesizes)[plane]) * plane_size.height();
+    }
+    if (input.padding == 0) {
+        linesizes->clear();
+    }
+    return data;
+}
+
+// 与 QmYuvView 的着色器相同的转换
+QColor expectedColor(uchar y, uchar u, uchar v)
+{
+    const double yy = y / 255.0;
+    const double uu = u / 255.0 - 0.5;
+    const double vv = v / 255.0 - 0.5;
+    auto channel = [](double value) { return static_cast<int>(std::lround(std::clamp(value, 0.0, 1.0) * 255)); };
+    return QColor(channel(yy + 1.402 * vv), channel(yy - 0.344 * uu - 0.714 * vv), channel(yy + 1.772 * uu));
+}
+
+bool closeTo(const QColor& a, const QColor& b)
+{
+    constexpr int kTolerance = 3;
+    return std::abs(a.red() - b.red()) <= kTolerance && std::abs(a.green() - b.green()) <= kTolerance && std::abs(a.blue() - b.blue()) <= kTolerance;
+}
+
+const char* formatName(QmYuvView::InputFormat format)
+{
+    switch (format) {
+    case QmYuvView::Nv12:
+        return "nv12";
+    case QmYuvView::Yuv420p10:
+        return "yuv420p10";
+    case QmYuvView::P010:
+        return "p010";
+    default:
+        return "yuv420p";
+    }
+}
+
+const char* modeName(QmYuvView::UploadMode mode)
+{
+    switch (mode) {
+    case QmYuvView::BufferedUpload:
+        return "buffered";
+    case QmYuvView::PersistentUpload:
+        return "persistent";
+    default:
+        return "direct";
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    // 帧数多于像素缓冲区个数，覆盖缓冲区的轮转复用
+    const uchar colors[][3] { { 81, 90, 240 }, { 145, 54, 34 }, { 41, 240, 110 }, { 235, 128, 128 }, { 16, 128, 128 } };
+    const QSize frame_size(37, 21);
+    // 先后切换格式，同时覆盖纹理重新分配
+    const Input inputs[] { { QmYuvView::Yuv420p, 0 }, { QmYuvView::Yuv420p, 28 }, { QmYuvView::Nv12, 0 }, { QmYuvView::Nv12, 12 },
+        { QmYuvView::Yuv420p10, 0 }, { QmYuvView::P010, 8 } };
+    int failures = 0;
+    for (auto mode : { QmYuvView::DirectUpload, QmYuvView::BufferedUpload, QmYuvView::PersistentUpload }) {
+        QmYuvView view;
+        view.setUploadMode(mode);
+        view.resize(64, 48);
+        view.show();
+        QCoreApplication::processEvents();
+        if (view.grabFramebuffer().isNull() || !view.isValid()) {
+            out << "no OpenGL context, skipped\n";
+            return kSkipped;
+        }
+        out << modeName(mode) << " -> " << modeName(view.uploadMode()) << "\n";
+
+        qint64 uploads = view.uploadCount();
+        for (const auto& input : inputs) {
+            for (const auto& color : colors) {
+                auto report = [&](const QString& what) {
+                    out << "FAIL " << modeName(mode) << " " << formatName(input.format) << " padding=" << input.padding << " " << what << "\n";
+                    ++failures;
+                };
+                QList<int> linesizes;
+                const QByteArray data = solidFrame(frame_size, input, color[0], color[1], color[2], &linesizes);
+                view.setData(data, frame_size, input.format, linesizes);
+                const QImage image = view.grabFramebuffer();
+                const QColor actual = image.pixelColor(image.width() / 2, image.height() / 2);
+                const QColor expected = expectedColor(color[0], color[1], color[2]);
+                if (!closeTo(actual, expected)) {
+                    report(QString("color %1 expected %2").arg(actual.name(), expected.name()));
+                }
+                if (view.uploadCount() != uploads + 1) {
+                    report(QString("new frame uploaded %1 times").arg(view.uploadCount() - uploads));
+                }
+                uploads = view.uploadCount();
+
+                // 没有新数据的重绘不应再次上传
+                const QImage repainted = view.grabFramebuffer();
+                if (view.uploadCount() != uploads) {
+                    report("repaint uploaded again");
+                }
+                if (!closeTo(repainted.pixelColor(repainted.width() / 2, repainted.height() / 2), expected)) {
+                    report("repaint lost the frame");
+                }
+            }
+        }
+    }
+
+    // 2x2 拼接，画面尺寸各不相同；更新一路后只上传该路
+    QmYuvMosaicView mosaic;
+    mosaic.setGrid(2, 2);
+    mosaic.resize(64, 48);
+    mosaic.show();
+    QCoreApplication::processEvents();
+    const QSize tile_sizes[] { { 37, 21 }, { 16, 16 }, { 20, 11 }, { 37, 21 } };
+    QColor expected_tiles[4];
+    for (int tile = 0; tile < 4; ++tile) {
+        QList<int> linesizes;
+        const auto& color = colors[tile];
+        mosaic.setData(tile, solidFrame(tile_sizes[tile], { QmYuvView::Yuv420p, 0 }, color[0], color[1], color[2], &linesizes), tile_sizes[tile]);
+        expected_tiles[tile] = expectedColor(color[0], color[1], color[2]);
+    }
+    auto check_tiles = [&](const char* step, qint64 expected_uploads) {
+        const QImage image = mosaic.grabFramebuffer();
+        for (int tile = 0; tile < 4; ++tile) {
+            const QColor actual = image.pixelColor((tile % 2 * 2 + 1) * image.width() / 4, (tile / 2 * 2 + 1) * image.height() / 4);
+            if (!closeTo(actual, expected_tiles[tile])) {
+                out << "FAIL mosaic " << step << " tile " << tile << " color " << actual.name() << " expected " << expected_tiles[tile].name() << "\n";
+                ++failures;
+            }
+        }
+        if (mosaic.uploadCount() != expected_uploads) {
+            out << "FAIL mosaic " << step << " uploads " << mosaic.uploadCount() << " expected " << expected_uploads << "\n";
+            ++failures;
+        }
+    };
+    check_tiles("initial", 4);
+    check_tiles("repaint", 4);
+    QList<int> linesizes;
+    const auto& color = colors[4];
+    mosaic.setData(2, solidFrame(tile_sizes[2], { QmYuvView::Yuv420p, 0 }, color[0], color[1], color[2], &linesizes), tile_sizes[2]);
+    expected_tiles[2] = expectedColor(color[0], color[1], color[2]);
+    check_tiles("update", 5);
+
+    out << (failures ? "FAILED " : "passed ") << failures << "\n";
+    return failures ? 1 : 0;
+}
\ No newline at end of file